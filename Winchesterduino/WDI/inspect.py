@@ -154,6 +154,8 @@ def showDriveParameters(params):
         print("Landing zone cylinder:\t" + str(params["lzStartCylinder"]))
     temp = "fast, buffered" if params["seekType"] == 0 else "slow, ST-506 compatible"
     print("Drive seeking mode:\t" + temp)
+    temp = ("constant", "ramped", "buffered burst")[params["seekProfile"]] if params["seekProfile"] < 3 else "unknown"
+    print("Step rate profile:\t" + temp)
     print("")
         
     return True
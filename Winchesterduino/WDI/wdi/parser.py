@@ -181,8 +181,11 @@ class WdiParser:
         partialImageEndCyl_msb = self._file.read(1)[0]
         partialImageEndCyl = (partialImageEndCyl_msb << 8) | partialImageEndCyl_lsb
         
+        # step rate profile (0: constant, 1: ramped, 2: buffered burst)
+        seekProfile = self._file.read(1)[0]
+        
         # read the padded rest to begin on first data field
-        self._file.read(12)
+        self._file.read(11)
         
         return {"result": True,
                 "description": description,
@@ -197,6 +200,7 @@ class WdiParser:
                 "lzEnabled": lzEnabled,
                 "lzStartCylinder": lzcyl,
                 "seekType": seekType,
+                "seekProfile": seekProfile,
                 "partialImage": partialImage,
                 "partialImageStartCylinder": partialImageStartCyl,
                 "partialImageEndCylinder": partialImageEndCyl}
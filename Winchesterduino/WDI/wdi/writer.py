@@ -100,7 +100,8 @@ class WdiWriter:
             self._outputFile.write(bytes([params["partialImageStartCylinder"] >> 8]))
             self._outputFile.write(bytes([params["partialImageEndCylinder"] & 0xFF]))
             self._outputFile.write(bytes([params["partialImageEndCylinder"] >> 8]))
-            self._outputFile.write(bytes([0]*12))
+            self._outputFile.write(bytes([params.get("seekProfile", 0)]))
+            self._outputFile.write(bytes([0]*11))
             return True
         
         except:
@@ -0,0 +1,105 @@
+# Winchesterduino (c) 2025 J. Bogin, http://boginjr.com
+# XMODEM receiver: CRC-16, 128 or 1024 byte frames, with an ACK after each frame or streaming (XMODEM-G),
+# optionally striped over two lines (DATA_CHANNEL_STRIPE): odd frames on the first one, even on the second,
+# single bytes (EOT, CAN) on both; requests and ACKs go back on the first one only
+
+import binascii
+import time
+
+SOH    = 0x01
+STX    = 0x02
+EOT    = 0x04
+ACK    = 0x06
+NAK    = 0x15
+CAN    = 0x18
+CRC    = 0x43 # 'C'
+STREAM = 0x47 # 'G'
+
+class XModemReceiver:
+    # read(count, timeout): up to count bytes, fewer or none on timeout (seconds); write(data)
+    # streaming: ask the sender with 'G' - frames come back to back, any error cancels the transfer
+    # ackDelay: seconds to wait before each ACK, emulates the turnaround of a slow link
+    # stripeRead: read() of the second line, if striped
+    def __init__(self, read, write, streaming=False, ackDelay=0.0, stripeRead=None):
+        self._reads = [read] if (stripeRead is None) else [read, stripeRead]
+        self._write = write
+        self._streaming = streaming
+        self._ackDelay = ackDelay
+        self.frames = 0
+        self.retries = 0
+        self.error = ""
+    
+    def _readExact(self, count, timeout, line=0):
+        data = b""
+        deadline = time.monotonic() + timeout
+        while (len(data) < count):
+            left = deadline - time.monotonic()
+            if (left <= 0):
+                return None
+            data += self._reads[line](count - len(data), left)
+        return data
+    
+    def _cancel(self, error):
+        self._write(bytes([CAN, CAN, CAN]))
+        self.error = error
+        return False
+    
+    # frames are written to output as they come, including the EOF padding of the last one
+    def receive(self, output, startTimeout=60):
+        request = bytes([STREAM if self._streaming else CRC])
+        header = None
+        deadline = time.monotonic() + startTimeout
+        while (header is None):
+            if (time.monotonic() > deadline):
+                self.error = "Sender did not start"
+                return False
+            self._write(request)
+            header = self._readExact(1, 1.0)
+        
+        expected = 1
+        while True:
+            line = (expected - 1) % len(self._reads) # the one frame number 'expected' arrives on
+            if (header is None):
+                header = self._readExact(1, 10.0, line)
+                if (header is None):
+                    return self._cancel("Timeout waiting for a frame")
+            kind = header[0]
+            header = None
+            
+            if (kind == EOT):
+                self._write(bytes([ACK]))
+                return True
+            if (kind == CAN):
+                self.error = "Cancelled by the sender"
+                return False
+            if ((kind != SOH) and (kind != STX)):
+                if (self._streaming):
+                    return self._cancel("Unexpected byte " + hex(kind))
+                continue # line noise, or a late request
+            
+            size = 1024 if (kind == STX) else 128
+            frame = self._readExact(2 + size + 2, 10.0, line)
+            if (frame is None):
+                return self._cancel("Timeout inside a frame")
+            
+            number = frame[0]
+            data = frame[2:2+size]
+            valid = ((number + frame[1]) == 255) and (binascii.crc_hqx(data, 0) == ((frame[-2] << 8) | frame[-1]))
+            if (not valid):
+                if (self._streaming):
+                    return self._cancel("Bad frame " + str(expected))
+                self.retries += 1
+                self._write(bytes([NAK]))
+                continue
+            
+            if (number == (expected & 0xFF)):
+                output.write(data)
+                expected += 1
+                self.frames += 1
+            elif (number != ((expected - 1) & 0xFF)): # not a repeated one either
+                return self._cancel("Frame " + str(number) + " out of sequence")
+            
+            if (not self._streaming):
+                if (self._ackDelay):
+                    time.sleep(self._ackDelay)
+                self._write(bytes([ACK]))
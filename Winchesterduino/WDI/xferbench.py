@@ -0,0 +1,228 @@
+# Winchesterduino (c) 2025 J. Bogin, http://boginjr.com
+# XMODEM throughput on a Linux pty loopback, ACK after each frame vs. streaming (XMODEM-G), and striped over two lines
+
+# Syntax: python xferbench.py [-b baud] [-l latency] [-k size]
+#         -b: line rates to emulate, bits per second, comma separated (default 500000,1000000,2000000; 0 for none),
+#         -l: USB serial bridge latency added to each ACK turnaround, milliseconds (default 4),
+#         -k: kilobytes to transfer per run (default 256).
+# The sender is the firmware's own src/XModem built for the host with g++, striping as TX() in image.cpp does,
+# the receiver is wdi.xmodem as used by xmrecv.py; the data of each frame is checked as well.
+
+import os
+import select
+import subprocess
+import sys
+import tempfile
+import time
+import tty
+
+from wdi.xmodem import XModemReceiver
+
+SENDER_SOURCE = r"""
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "XModem.h"
+
+static int ports[2];
+static int portCount;
+static unsigned long blocks;
+
+static int recvChar(int msDelay)
+{
+  struct pollfd pfd[2] = {{ports[0], POLLIN, 0}, {ports[1], POLLIN, 0}};
+  unsigned char value;
+  if (poll(pfd, portCount, msDelay) > 0)
+  {
+    for (int index = 0; index < portCount; index++)
+      if ((pfd[index].revents & POLLIN) && (read(ports[index], &value, 1) == 1))
+        return value;
+  }
+  return -1;
+}
+
+static void sendPort(int port, const char* data, int len)
+{
+  while (len > 0)
+  {
+    const int written = write(port, data, len);
+    if (written > 0)
+    {
+      data += written;
+      len -= written;
+    }
+    else if ((errno != EAGAIN) && (errno != EINTR))
+      return;
+  }
+}
+
+// striped: odd frames on the first port, even on the second, single bytes on both
+static void sendData(const char* data, int len)
+{
+  if ((portCount > 1) && (len > 1))
+  {
+    sendPort((data[1] & 1) ? ports[0] : ports[1], data, len);
+    return;
+  }
+  for (int index = 0; index < portCount; index++)
+    sendPort(ports[index], data, len);
+}
+
+static bool dataHandler(unsigned long number, char* buffer, int len)
+{
+  if (number > blocks)
+    return false;
+  memset(buffer, (char)number, len);
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  portCount = (argc > 4) ? 2 : 1;
+  for (int index = 0; index < portCount; index++)
+  {
+    ports[index] = open(argv[index ? 4 : 1], O_RDWR | O_NOCTTY);
+    struct termios raw;
+    tcgetattr(ports[index], &raw);
+    cfmakeraw(&raw);
+    tcsetattr(ports[index], TCSANOW, &raw);
+  }
+  blocks = strtoul(argv[2], NULL, 10);
+  XModem modem(recvChar, sendData, dataHandler, argv[3][0] == '1');
+  return modem.transmit() ? 0 : 1;
+}
+"""
+
+def main():
+    rates = [500000, 1000000, 2000000]
+    latency = 4
+    kilobytes = 256
+    idx = 1
+    try:
+        while (idx < len(sys.argv)):
+            option = sys.argv[idx].lower()
+            if (option == "-b"):
+                rates = [int(rate) for rate in sys.argv[idx+1].split(",")]
+            elif (option == "-l"):
+                latency = float(sys.argv[idx+1])
+            elif (option == "-k"):
+                kilobytes = int(sys.argv[idx+1])
+            else:
+                raise ValueError
+            idx += 2
+    except (ValueError, IndexError):
+        showUsage()
+        return
+    
+    workDir = tempfile.mkdtemp()
+    sender = buildSender(workDir)
+    if (sender is None):
+        return
+    
+    print("Turnaround latency: " + str(latency) + " ms, " + str(kilobytes) + " KB per run")
+    for baud in rates:
+        print("")
+        print("Line rate: " + (str(baud) + " bps" if baud else "unlimited"))
+        for frameSize in [128, 1024]:
+            for streaming in [False, True]:
+                result = runTransfer(sender, frameSize, streaming, baud, latency / 1000.0, kilobytes * 1024)
+                name = ("XMODEM-1K" if (frameSize == 1024) else "XMODEM") + ("-G streaming" if streaming else " ACK per frame")
+                print(name.ljust(28) + result)
+        result = runTransfer(sender, 1024, True, baud, latency / 1000.0, kilobytes * 1024, 2)
+        print("XMODEM-1K-G striped x2".ljust(28) + result)
+
+def buildSender(workDir):
+    sourceDir = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src", "XModem")
+    shim = os.path.join(workDir, "sender.cpp")
+    binary = os.path.join(workDir, "sender")
+    with open(shim, "w") as file:
+        file.write(SENDER_SOURCE)
+    
+    build = subprocess.run(["g++", "-O2", "-I", sourceDir, "-o", binary, shim, os.path.join(sourceDir, "XModem.cpp")],
+                           capture_output=True, text=True)
+    if (build.returncode != 0):
+        print("Cannot build the sender with g++:")
+        print(build.stderr)
+        return None
+    return binary
+
+def runTransfer(sender, frameSize, streaming, baud, ackDelay, totalBytes, lines=1):
+    ptys = [os.openpty() for line in range(lines)]
+    for master, slave in ptys:
+        tty.setraw(master)
+    arguments = [sender, os.ttyname(ptys[0][1]), str(totalBytes // frameSize), "1" if (frameSize == 1024) else "0"]
+    if (lines > 1):
+        arguments.append(os.ttyname(ptys[1][1]))
+    process = subprocess.Popen(arguments)
+    
+    # the pty has no line rate of its own: hold the reads back to what the emulated line would deliver,
+    # the lines being idle from each of our writes (the sender waits for them) until the data that follows;
+    # striped, each line delivers in parallel with the other, on its own time
+    state = {"bytes": 0, "start": None, "due": [0.0] * lines}
+    def reader(line):
+        master = ptys[line][0]
+        def read(count, timeout):
+            ready = select.select([master], [], [], timeout)[0]
+            if (not ready):
+                return b""
+            data = os.read(master, count)
+            now = time.monotonic()
+            if (state["start"] is None):
+                state["start"] = now
+                state["due"] = [now] * lines
+            state["bytes"] += len(data)
+            if (baud):
+                state["due"][line] += len(data) * 10.0 / baud
+                delay = state["due"][line] - now
+                if (delay > 0):
+                    time.sleep(delay)
+            return data
+        return read
+    
+    def write(data):
+        state["due"] = [max(due, time.monotonic()) for due in state["due"]]
+        os.write(ptys[0][0], data)
+    
+    # frame n is filled with the byte n by the sender
+    class Sink:
+        def __init__(self):
+            self.size = 0
+            self.valid = True
+        def write(self, data):
+            frameNo = (self.size // frameSize) + 1
+            self.valid = self.valid and (data == bytes([frameNo & 0xFF]) * len(data))
+            self.size += len(data)
+    
+    sink = Sink()
+    receiver = XModemReceiver(reader(0), write, streaming, ackDelay, reader(1) if (lines > 1) else None)
+    ok = receiver.receive(sink, 10)
+    elapsed = time.monotonic() - state["start"] if state["start"] else 0
+    process.wait(10)
+    for master, slave in ptys:
+        os.close(master)
+        os.close(slave)
+    
+    if (not ok):
+        return "failed: " + receiver.error
+    if (sink.size != totalBytes):
+        return "failed: received " + str(sink.size) + " of " + str(totalBytes) + " bytes"
+    if (not sink.valid):
+        return "failed: frames out of order"
+    # line utilization: everything on the wire (framing included) over what the line(s) could carry in the time
+    result = "{:8.1f} KB/s".format((sink.size / 1024.0) / elapsed)
+    if (baud):
+        result += ", line busy {:3.0f}%".format((state["bytes"] * 10.0 / (baud * lines)) * 100.0 / elapsed)
+    return result
+
+def showUsage():
+    print("Syntax: python xferbench.py [-b baud] [-l latency] [-k size]")
+    print("-b: line rates to emulate, bits per second, comma separated (default 500000,1000000,2000000; 0 for none)")
+    print("-l: USB serial bridge latency added to each ACK turnaround, milliseconds (default 4)")
+    print("-k: kilobytes to transfer per run (default 256)")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,117 @@
+# Winchesterduino (c) 2025 J. Bogin, http://boginjr.com
+# Disk image receiver for the data channel (DATA_CHANNEL), also striped over two (DATA_CHANNEL_STRIPE)
+
+# Syntax: python xmrecv.py output.wdi port [stripeport] [-b baud] [-a]
+#         port: serial device of DATA_CHANNEL, such as /dev/ttyUSB1,
+#         stripeport: serial device of DATA_CHANNEL_STRIPE, if set,
+#         -b: line rate, bits per second (default 2000000, as DATA_BAUD_RATE),
+#         -a: ACK after each frame, instead of streaming (XMODEM-G).
+# Uses termios, so POSIX systems only. Start it before, or up to 4 minutes after choosing Read image.
+
+import os
+import select
+import sys
+import termios
+import tty
+
+from wdi.xmodem import XModemReceiver
+
+def main():
+    paths = []
+    baud = 2000000
+    streaming = True
+    idx = 1
+    try:
+        while (idx < len(sys.argv)):
+            option = sys.argv[idx]
+            if (option.lower() == "-b"):
+                baud = int(sys.argv[idx+1])
+                idx += 1
+            elif (option.lower() == "-a"):
+                streaming = False
+            else:
+                paths.append(option)
+            idx += 1
+    except (ValueError, IndexError):
+        paths = []
+    
+    if ((len(paths) < 2) or (len(paths) > 3)):
+        showUsage()
+        return
+    
+    try:
+        ports = [openPort(path, baud) for path in paths[1:]]
+    except (OSError, ValueError) as error:
+        print("Cannot open the serial port(s): " + str(error))
+        return
+    
+    try:
+        output = open(paths[0], "wb")
+    except OSError:
+        print("Cannot open output file")
+        return
+    
+    print("Waiting for the transfer, press Ctrl+C to abort...")
+    progress = Progress(output)
+    stripeRead = reader(ports[1]) if (len(ports) > 1) else None
+    receiver = XModemReceiver(reader(ports[0]), lambda data: os.write(ports[0], data), streaming, 0.0, stripeRead)
+    try:
+        ok = receiver.receive(progress, 240)
+    except KeyboardInterrupt:
+        os.write(ports[0], bytes([0x18, 0x18, 0x18]))
+        ok = False
+        receiver.error = "Aborted"
+    
+    output.close()
+    for port in ports:
+        os.close(port)
+    
+    print("")
+    if (not ok):
+        print("Transfer failed: " + receiver.error)
+        return
+    print("Received " + str(progress.size) + " bytes in " + str(receiver.frames) + " frames")
+
+def openPort(path, baud):
+    speed = getattr(termios, "B" + str(baud), None)
+    if (speed is None):
+        raise ValueError("line rate " + str(baud) + " not supported here")
+    
+    port = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(port)
+    attributes = termios.tcgetattr(port)
+    attributes[4] = speed
+    attributes[5] = speed
+    termios.tcsetattr(port, termios.TCSANOW, attributes)
+    termios.tcflush(port, termios.TCIOFLUSH)
+    return port
+
+def reader(port):
+    def read(count, timeout):
+        if (not select.select([port], [], [], timeout)[0]):
+            return b""
+        return os.read(port, count)
+    return read
+
+# writes the output file, showing how much came in
+class Progress:
+    def __init__(self, output):
+        self.output = output
+        self.size = 0
+    
+    def write(self, data):
+        self.output.write(data)
+        self.size += len(data)
+        if (not (self.size % 65536)):
+            print("\r" + str(self.size // 1024) + " KB", end="", flush=True)
+
+def showUsage():
+    print("Receives a disk image from the Winchesterduino data channel(s).\n")
+    print("Syntax: python xmrecv.py output.wdi port [stripeport] [-b baud] [-a]")
+    print("port: serial device of DATA_CHANNEL, such as /dev/ttyUSB1")
+    print("stripeport: serial device of DATA_CHANNEL_STRIPE, if set")
+    print("-b: line rate, bits per second (default 2000000, as DATA_BAUD_RATE)")
+    print("-a: ACK after each frame, instead of streaming (XMODEM-G)")
+
+if __name__ == "__main__":
+    main()
@@ -15,11 +15,29 @@
 #define SEEK_PULSE_US          3         // seek pulse length, microseconds
 #define SLOWSEEK_SRT_MS        4         // head step rate time in ms to wait before next step (slow seek mode)
 #define FASTSEEK_SRT_US        10        // microseconds to wait before next step (buffered seek)
+#define RAMPSEEK_SRT_US        500       // ramped step rate profile: accelerate from SLOWSEEK_SRT_MS down to this, and back before the last step
+#define BURSTSEEK_SRT_US       5         // buffered burst step rate profile: microseconds to wait before next step (not less than STEP_ISR_LATENCY_US)
+#define STEP_ISR_LATENCY_US    8         // worst case the step pulse timer interrupts are held off by another one (/MCINT with micros(), timer 0, USARTs)
+#define FAST_RECALIBRATE       1         // set to 0 to always find cylinder 0 by slow single steps (20ms each)
+#define RECAL_BURST_STEPS      64        // fast recalibrate: buffered steps per burst before /TRK0 is checked
+#define TRAVERSAL_ORDER        2         // image read, scan and analyze: 0 linear, 1 serpentine heads, 2 serpentine from the nearer end (see main.h)
+
+// spindle
+#define ROTATION_REVOLUTIONS   32        // revolutions timed by measureRotation()
+#define ROTATION_JITTER_WARN   50        // warn before imaging if revolutions differ more than this, in 1/10000 of the period (0.5%)
 
 // UI defines
 #define MAX_PROGMEM_STRING_LEN 60        // maximum number of characters for each string in PROGMEM, MAX+1 size of buffer for pgm_read_ptr()
 #define MAX_CHARS              100       // ui->print() buffer size
 #define MAX_PROMPT_LEN         100       // ui->prompt() buffer size
+#define SERIAL_BAUD_RATE       115200    // terminal and XMODEM line rate; 500000, 1000000 or 2000000 are exact at 16 MHz, if the USB bridge and terminal support them
+#define SERIAL_XON_XOFF        0         // set to 1 to pause on XOFF from the terminal, and to send XOFF when receiving faster than consumed (advised at >= 1 Mbps)
+#define SERIAL_RX_RING_SIZE    256       // serial receive ring; with XON/XOFF, half of it is left for what is still on the way after our XOFF
+#define DATA_CHANNEL           0         // image transfers: 0 over the console, 1..3 over USART1..3 (TX/RX pins 18/19, 16/17, 14/15) to another USB serial adapter,
+                                         // while the console shows the progress and Esc aborts
+#define DATA_CHANNEL_STRIPE    0         // 1..3, other than DATA_CHANNEL: image reads striped over a second USART (odd XMODEM frames on the first one,
+                                         // even on this one, see WDI/xmrecv.py)
+#define DATA_BAUD_RATE         2000000   // data channel line rate
 
 // filesystem defines
 #define MAX_PATH               100       // max path, MAX_PATH+1 size of path buffer
@@ -43,6 +61,7 @@
 // our common includes
 #include "progmem.h"
 #include "ui.h"
+#include "pool.h"
 #include "wd42c22.h"
 #include "image.h"
 #include "eeprom.h"
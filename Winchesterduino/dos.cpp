@@ -27,6 +27,11 @@ WORD DOSGetSectorSize()
   return sectorSizeBytes;
 }
 
+BYTE DOSGetSectorsPerTrack()
+{
+  return sectorsPerTrack;
+}
+
 DWORD DOSGetTotalSectorCount()
 {
    return (DWORD)wdc->getParams()->Cylinders * wdc->getParams()->Heads * sectorsPerTrack;
@@ -102,12 +107,14 @@ bool DOSInitialize()
 {
   // look at track 0
   WORD dummy;
-  BYTE dummy2;
   BYTE sdh;
+  WD42C22::TrackGeometry geometry;
   
   wdc->seekDrive(0, 0);
-  wdc->scanID(dummy, dummy2, sdh);
-  if (wdc->getLastError())
+  DWORD* result = ScanTrack(sdh, dummy, geometry);
+  sectorsPerTrack = geometry.SectorsPerTrack;
+  const bool weirdGeometry = geometry.Flags & (TRACK_HEAD_MISMATCH | TRACK_CYLINDER_MISMATCH | TRACK_VARIABLE_SIZE); // :-)
+  if (!result || !sectorsPerTrack)
   {
     ui->print(Progmem::getString(Progmem::analyzeNoSectors));
     ui->print(Progmem::getString(Progmem::uiNewLine));
@@ -115,46 +122,22 @@ bool DOSInitialize()
   }
   
   sectorSizeBytes = wdc->getSectorSizeFromSDH(sdh);  
-  if (!sectorSizeBytes || (sectorSizeBytes > 512))
-  {
-    ui->print(Progmem::getString(Progmem::dosInvalidSsize), sectorSizeBytes);
-    ui->print(Progmem::getString(Progmem::uiNewLine));
-    return false;
-  }
-  
-  bool weirdGeometry = false; // :-)
-  DWORD* result = CalculateSectorsPerTrack(sdh, sectorsPerTrack, dummy,
-                                           weirdGeometry, weirdGeometry, weirdGeometry);
-  if (!result || !sectorsPerTrack || weirdGeometry)
+  if (!sectorSizeBytes || (sectorSizeBytes > 512) || weirdGeometry)
   {
-    if (result)
+    if (weirdGeometry)
     {
-      // sectors table
-      delete[] result;
+      ui->print(Progmem::getString(Progmem::analyzeNoSectors));
+    }
+    else
+    {
+      ui->print(Progmem::getString(Progmem::dosInvalidSsize), sectorSizeBytes);
     }
-    
-    ui->print(Progmem::getString(Progmem::analyzeNoSectors));
     ui->print(Progmem::getString(Progmem::uiNewLine));
     return false;
   }  
   
-  // determine starting sector, find the lowest (some XT disks start from 0)
-  startingSector = (BYTE)-1;
-  for (WORD idx = 0; idx < dummy /* tableCount */; idx++)
-  {
-    const DWORD& sectorData = result[idx];
-    if (sectorData == 0xFFFFFFFFUL) // undefined
-    {
-      continue;
-    }
-    
-    const BYTE sector = (BYTE)(sectorData >> 16);
-    if (sector < startingSector)
-    {
-      startingSector = sector;
-    }
-  }
-  delete[] result;
+  // starting sector, the lowest one (some XT disks start from 0)
+  startingSector = geometry.StartSector;
   
   // set root directory and try to mount first partition
   memset(path, 0, sizeof(path));
@@ -210,20 +193,15 @@ void DOSHexdump(const BYTE* fileName)
   WORD count = 1;
   FAT_EXECUTE(f_open(&file, addPath, FA_READ));
   
-  BYTE* chunk = new BYTE[512];
-  if (!chunk)
-  {
-    ui->fatalError(Progmem::uiFeMemory);
-  }
+  BYTE* chunk = PoolGetScratch();
   
   ui->print(Progmem::getString(Progmem::uiNewLine));
   ui->print(Progmem::getString(Progmem::hexdumpDump));
   
   while (count)
   {
-    if (DOSResult(f_read(&file, chunk, 512, &count)) != FR_OK)
+    if (DOSResult(f_read(&file, chunk, POOL_SCRATCH_SIZE, &count)) != FR_OK)
     {
-      delete[] chunk;
       f_close(&file);
       return;
     }
@@ -234,7 +212,6 @@ void DOSHexdump(const BYTE* fileName)
     }
   }
   
-  delete[] chunk;  
   FAT_EXECUTE(f_close(&file));
   ui->print(Progmem::getString(Progmem::uiNewLine2x));
 }
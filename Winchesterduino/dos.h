@@ -2,6 +2,7 @@
 // DOS filesystem viewer
 
 WORD  DOSGetSectorSize();
+BYTE  DOSGetSectorsPerTrack();
 DWORD DOSGetTotalSectorCount();
 void  DOSConvertLogicalSectorToCHS(const DWORD& logical, WORD& cylinder, BYTE& head, BYTE& sector);
 
@@ -6,12 +6,35 @@
 // forward decl's
 int  RX(int msDelay);
 void TX(const char *data, int size);
+void ShowDataChannel(bool striped);
 
 // XMODEM callback related
 void CbCleanup();
 bool CbReadDisk(DWORD packetNo, BYTE* data, WORD size);
 bool CbWriteDisk(DWORD packetNo, BYTE* data, WORD size);
 bool CbVerifyParamsFromImage();
+bool CbReadTrackWindow();
+bool CbSeekNextTrack();
+WORD WdiStreamFill(BYTE* data, WORD size);
+void StreamPut(const BYTE* bytes, WORD count);
+void StreamPutSram(WORD offset, WORD count, bool correct);
+WORD StreamDrain(BYTE* data, WORD size);
+bool WdiEncodeNext();
+bool WdiEncodeTrack();
+bool WdiEncodeSector();
+bool WdiNextTrack();
+
+// physical order track reads: sectors to let pass under the head after one was read, before the next one can be caught
+#define TRACK_READ_SKIP 1
+// zero latency window reads: a run of consecutive sectors is read beginning with the one coming under the head, 0 to wait for its first
+#define TRACK_READ_ZERO_LATENCY 1
+
+// WDI records, in the order the read disk encoder emits them
+#define RECORD_HEADER       0 // header and comment, up to EOF
+#define RECORD_DRIVE_TABLE  1
+#define RECORD_TRACK        2 // cylinder, head, sectors per track, sector numbering map
+#define RECORD_SECTOR       3 // data record type and data, each sector of the map
+#define RECORD_DONE         4
 
 // values not modified by CbCleanup()
 BYTE cbProgmemResponseStr      = 0;
@@ -20,6 +43,12 @@ DWORD cbTotalDataErrors        = 0;
 DWORD cbTotalCorrectedErrors   = 0;
 DWORD cbTotalBadBlocks         = 0;
 DWORD cbUnreadableTracks       = 0;
+DWORD cbRevolutions            = 0; // 1/100s of disk revolutions spent reading data, all tracks
+DWORD cbTracksRead             = 0;
+bool cbAborted                 = false; // Esc on the console, while on a separate data channel
+bool cbStriped                 = false; // read disk over DATA_CHANNEL_STRIPE as well
+Traversal cbTraversal;                // read disk: order of the tracks, see TRAVERSAL_ORDER
+WORD cbHeaderLength            = 0; // read disk: WDI header and comment in SRAM, incl. EOF
 // write image to disk options:
 bool cbWriteImgOverrideParams  = false;
 BYTE cbWriteImgBadSectorMode   = 0; // 0: bad sectors formatted empty, 1: bad sectors formatted as bad
@@ -46,6 +75,17 @@ WORD cbSectorIdx               = 0;
 WORD cbStartingSectorIdx       = (WORD)-1;
 BYTE cbSectorDataType          = 0;
 WORD cbSecSizeBytes            = 0;
+BYTE cbMapIdx[100]             = {0}; // sectors table index of each sector in the order of the map, up to fillSectorsTable count
+WORD cbBurstPos                = 0; // map position of the first sector in SRAM
+BYTE cbBurstCount              = 0; // and how many are there
+BYTE cbBurstStatus[16]         = {0}; // WDC result of each
+BYTE cbRecord                  = RECORD_HEADER; // read disk: next record to encode
+WORD cbStreamHead              = 0; // encoded bytes in PoolGetStream(), not yet in a packet: from tail to head
+WORD cbStreamTail              = 0;
+WORD cbStreamSramOffset        = 0; // then data of a record still in SRAM
+WORD cbStreamSramCount         = 0;
+bool cbStreamSramCorrect       = false; // with ECC corrections applied
+DWORD cbTrackReadMicros        = 0; // time spent reading the current track
 
 void CommandReadImage()
 { 
@@ -127,6 +167,23 @@ void CommandReadImage()
     }
   }
   
+  // tracks in the traversal order, from where the heads are now
+  if (!wdc->getParams()->PartialImage)
+  {
+    TraversalBegin(cbTraversal, 0, wdc->getParams()->Cylinders-1);
+  }
+  else
+  {
+    TraversalBegin(cbTraversal, wdc->getParams()->PartialImageStartCyl, wdc->getParams()->PartialImageEndCyl);
+  }
+  
+  // an unstable spindle would likely fail somewhere during a long transfer
+  if (!CheckRotationStable(cbTraversal.Cylinder))
+  {
+    ui->print(Progmem::getString(Progmem::uiNewLine));
+    return;
+  }
+  
   // ask to use 1K packets
   bool useXMODEM1K = false;
   BYTE* testAlloc = new BYTE[1030];
@@ -191,38 +248,45 @@ void CommandReadImage()
   
   // EOF marks the end of header
   wdc->sramWriteByteSequential(0x1A);
-  wdc->sramBeginBufferAccess(false, 0); // prepare reading
+  wdc->sramFinishBufferAccess();
+  cbHeaderLength = len + 1;
   
   // copy current disk drive parameters
   memcpy(&cbParams, wdc->getParams(), sizeof(WD42C22::DiskDriveParams));
   
   // seek to the beginning
-  if (!wdc->getParams()->PartialImage)
-  {
-    wdc->seekDrive(0, 0);
-  }
-  else
-  {
-    wdc->seekDrive(wdc->getParams()->PartialImageStartCyl, 0);
-  }  
+  wdc->seekDrive(cbTraversal.Cylinder, cbTraversal.Head);
   
   ui->print("");
   ui->print(Progmem::getString(useXMODEM1K ? Progmem::imgXmodem1kPrefix : Progmem::imgXmodemPrefix));
   ui->print(Progmem::getString(Progmem::imgXmodemWaitRecv));
-  ui->setPrintDisabled(true);
+  ShowDataChannel(true);
   
   // reset values that are not modified by CbCleanup()
   cbProgmemResponseStr = 0;
   cbSuccess = false;
   cbInProgress = true;
+  cbAborted = false;
   cbTotalDataErrors = 0;
   cbTotalCorrectedErrors = 0;
   cbTotalBadBlocks = 0;
   cbUnreadableTracks = 0;
+  cbRevolutions = 0;
+  cbTracksRead = 0;
+  wdc->resetBusCycles();
+  wdc->resetCommandStats();
+  wdc->setDeferredCorrection(true); // ECC corrections applied as the sectors go into the packets
   
-  // read and transmit
+  // read and transmit, packets queued to the transmit ring so that the next reads overlap with the line
+#if DATA_CHANNEL_STRIPE
+  cbStriped = true;
+#endif
+  ui->txBegin();
   XModem modem(RX, TX, &CbReadDisk, useXMODEM1K);
   modem.transmit();
+  ui->txEnd();
+  cbStriped = false;
+  wdc->setDeferredCorrection(false);
   CbCleanup();
   DumpSerialTransfer();
   wdc->selectDrive(false);
@@ -252,6 +316,34 @@ void CommandReadImage()
       ui->print(Progmem::getString(Progmem::imgDataCorrected), cbTotalCorrectedErrors);  
     }    
     ui->print(Progmem::getString(Progmem::imgDataErrors), cbTotalDataErrors);
+    if (cbTracksRead)
+    {
+      const DWORD average = cbRevolutions / cbTracksRead;
+      ui->print(Progmem::getString(Progmem::imgRevolutions), average / 100, average % 100);
+    }
+    ui->print(Progmem::getString(Progmem::imgBusCycles), wdc->getBusCycles(), wdc->getBusCyclesSaved());
+    
+    // serial line utilization: bits sent over the bits that could have been, in the same time
+    const DWORD elapsed = ui->getTxMillis();
+    if (elapsed >= 100)
+    {
+#if DATA_CHANNEL_STRIPE
+      const DWORD busy = (ui->getTxBytes() * 10) / (ui->getBaudRate(PORT_DATA) / 1000) / 2;
+#else
+      const DWORD busy = (ui->getTxBytes() * 10) / (ui->getBaudRate(PORT_DATA) / 1000);
+#endif
+      ui->print(Progmem::getString(Progmem::imgLinkBusy), busy / (elapsed / 100), elapsed / 1000, ui->getTxStallMillis());
+    }
+    
+    // WDC command latencies, by opcode group
+    for (BYTE group = 0; group < 16; group++)
+    {
+      const WD42C22::CommandStats& stats = wdc->getCommandStats(group << 4);
+      if (stats.Count)
+      {
+        ui->print(Progmem::getString(Progmem::imgCommandStats), group << 4, stats.Count, stats.TotalMicros / stats.Count, stats.MaxMicros);
+      }
+    }
   }
   
   ui->print(Progmem::getString(Progmem::uiNewLine));
@@ -415,19 +507,22 @@ void CommandWriteImage()
   ui->print("");
   ui->print(Progmem::getString(useXMODEM1K ? Progmem::imgXmodem1kPrefix : Progmem::imgXmodemPrefix));
   ui->print(Progmem::getString(Progmem::imgXmodemWaitSend));
-  ui->setPrintDisabled(true);
+  ShowDataChannel(false);
   
   // reset values that are not modified by CbCleanup()
   cbProgmemResponseStr = 0;
   cbSuccess = false;
   cbInProgress = true;
+  cbAborted = false;
   cbTotalDataErrors = 0;
   cbTotalBadBlocks = 0;
   cbUnreadableTracks = 0;
   
   // receive and write
+  ui->setBinaryReceive(true);
   XModem modem(RX, TX, &CbWriteDisk, useXMODEM1K);
   modem.receive();
+  ui->setBinaryReceive(false);
   // finished, later ask to restore previous drive settings if it processed fine
   const bool askRestore = cbWriteImgOverrideParams && !cbProcessingHeader && !cbProcessingDriveTable;
   CbCleanup();
@@ -481,21 +576,66 @@ void CommandWriteImage()
 // XMODEM
 int RX(int msDelay) 
 { 
+  // checked at least once, msDelay 0 is a poll
   const DWORD start = millis();
-  while ((millis()-start) < msDelay)
+  do
   { 
-    if (Serial.available())
+#if DATA_CHANNEL
+    // the console stays live: Esc cancels, and keeps cancelling until XMODEM gives up
+    if (cbAborted || (ui->rxRead(PORT_CONSOLE) == '\e'))
+    {
+      cbAborted = true;
+      return XModem::CAN;
+    }
+#endif
+    int data = ui->rxRead(PORT_DATA);
+#if DATA_CHANNEL_STRIPE
+    if ((data < 0) && cbStriped)
+    {
+      data = ui->rxRead(PORT_STRIPE);
+    }
+#endif
+    if (data >= 0)
     {
-      return (BYTE)Serial.read();
+      return data;
     }
   }
+  while ((millis()-start) < (DWORD)msDelay);
 
   return -1; 
 }
 
 void TX(const char *data, int size)
 {  
-  Serial.write((const BYTE*)data, size);
+#if DATA_CHANNEL_STRIPE
+  // striped: frames with odd numbers on the data channel and even ones on the other, single bytes (EOT, CAN) on both
+  if (cbStriped)
+  {
+    if (size > 1)
+    {
+      ui->txWrite((const BYTE*)data, size, (data[1] & 1) ? PORT_DATA : PORT_STRIPE);
+      return;
+    }
+    ui->txWrite((const BYTE*)data, size, PORT_STRIPE);
+  }
+#endif
+  ui->txWrite((const BYTE*)data, size, PORT_DATA);
+}
+
+// where the transfer goes; on the console itself, nothing else can be printed until it finishes
+void ShowDataChannel(bool striped)
+{
+#if DATA_CHANNEL
+  ui->print(Progmem::getString(Progmem::imgDataChannel), PORT_DATA, ui->getBaudRate(PORT_DATA));
+#if DATA_CHANNEL_STRIPE
+  if (striped)
+  {
+    ui->print(Progmem::getString(Progmem::imgDataStriped), PORT_DATA, PORT_STRIPE);
+  }
+#endif
+#else
+  ui->setPrintDisabled(true);
+#endif
 }
 
 bool IsSerialTransfer()
@@ -511,29 +651,22 @@ void DumpSerialTransfer()
   DWORD delayMs = millis() + 10;
   while (millis() < delayMs)
   {
-    if (Serial.read() >= 0)
+    if (ui->rxRead(PORT_DATA) >= 0)
     {
       delayMs = millis() + 10;
     }
   }
   
-  while (Serial.available() > 0)
-  {
-    Serial.read(); 
-  }
+  while (ui->rxRead(PORT_DATA) >= 0);
   
-  Serial.write(&CAN, sizeof(BYTE));
-  Serial.write(&CAN, sizeof(BYTE));
-  Serial.write(&CAN, sizeof(BYTE));
+  ui->txWrite(&CAN, sizeof(BYTE), PORT_DATA);
+  ui->txWrite(&CAN, sizeof(BYTE), PORT_DATA);
+  ui->txWrite(&CAN, sizeof(BYTE), PORT_DATA);
 }
 
 void CbCleanup()
 {
-  if (cbSectorsTable)
-  {
-    delete[] cbSectorsTable;
-    cbSectorsTable = NULL;
-  }
+  cbSectorsTable = NULL;
   
   cbInProgress              = false;
   cbProcessingHeader        = true;
@@ -554,17 +687,24 @@ void CbCleanup()
   cbStartingSectorIdx       = (WORD)-1;
   cbSectorDataType          = 0;
   cbSecSizeBytes            = 0;
+  cbBurstPos                = 0;
+  cbBurstCount              = 0;
+  cbTrackReadMicros         = 0;
+  cbRecord                  = RECORD_HEADER;
+  cbStreamHead              = 0;
+  cbStreamTail              = 0;
+  cbStreamSramOffset        = 0;
+  cbStreamSramCount         = 0;
+  cbStreamSramCorrect       = false;
   
   memset(&cbParams, 0, sizeof(cbParams));
   
   wdc->sramFinishBufferAccess();
 }
 
-// read disk callback
+// read disk callback: XMODEM packets out of the WDI stream
 bool CbReadDisk(DWORD packetNo, BYTE* data, WORD size)
 {
-  WORD packetIdx = 0;
-  
   if (!data || ((size != 128) && (size != 1024)))
   {
     cbSuccess = false;
@@ -576,499 +716,575 @@ bool CbReadDisk(DWORD packetNo, BYTE* data, WORD size)
   // as XMODEM sends fixed 128B or 1024B packets
   memset(data, 0x1A, size);
   
-  // end of transfer
-  if ((cbCylinder == wdc->getParams()->Cylinders) ||
-      (wdc->getParams()->PartialImage && (cbCylinder-1 == wdc->getParams()->PartialImageEndCyl)))
+  // nothing more: end of transfer, or an error
+  return WdiStreamFill(data, size) != 0;
+}
+
+// transport: fills one frame from the encoder output, encoding further records whenever that runs dry;
+// returns how many bytes, less than size only in the last frame of the image, 0 after it or on an error (see cbSuccess)
+WORD WdiStreamFill(BYTE* data, WORD size)
+{
+  WORD filled = 0;
+  for (;;)
   {
+    filled += StreamDrain(&data[filled], size - filled);
+    if ((filled == size) || (cbRecord == RECORD_DONE))
+    {
+      return filled;
+    }
+    
+    // all of it went out, the next record
+    if (!WdiEncodeNext())
+    {
+      return 0;
+    }
+  }
+}
+
+// queue bytes of a record
+void StreamPut(const BYTE* bytes, WORD count)
+{
+  memcpy(&PoolGetStream()[cbStreamHead], bytes, count);
+  cbStreamHead += count;
+}
+
+// queue data that stays in SRAM until copied into the frames, as the last part of a record
+void StreamPutSram(WORD offset, WORD count, bool correct)
+{
+  cbStreamSramOffset = offset;
+  cbStreamSramCount = count;
+  cbStreamSramCorrect = correct;
+}
+
+// copy out what is queued, the bytes first, then the SRAM span
+WORD StreamDrain(BYTE* data, WORD size)
+{
+  WORD count = cbStreamHead - cbStreamTail;
+  if (count > size)
+  {
+    count = size;
+  }
+  memcpy(data, &PoolGetStream()[cbStreamTail], count);
+  cbStreamTail += count;
+  if (cbStreamTail != cbStreamHead)
+  {
+    return count;
+  }
+  cbStreamHead = 0;
+  cbStreamTail = 0;
+  
+  WORD sramCount = cbStreamSramCount;
+  if (sramCount > size - count)
+  {
+    sramCount = size - count;
+  }
+  if (sramCount)
+  {
+    wdc->sramBeginBufferAccess(false, cbStreamSramOffset);
+    wdc->sramReadBlock(&data[count], sramCount);
+    wdc->sramFinishBufferAccess();
+    if (cbStreamSramCorrect)
+    {
+      wdc->applyCorrections(&data[count], cbStreamSramOffset, sramCount);
+    }
+    cbStreamSramOffset += sramCount;
+    cbStreamSramCount -= sramCount;
+  }
+  
+  return count + sramCount;
+}
+
+// encoder: queues the next whole record, only called with nothing queued
+// (so that no SRAM span is pending when the next window is read); false on an error, cbSuccess and cbProgmemResponseStr set
+bool WdiEncodeNext()
+{
+  switch (cbRecord)
+  {
+  case RECORD_HEADER:
+    StreamPutSram(0, cbHeaderLength, false);
+    cbRecord = RECORD_DRIVE_TABLE;
+    return true;
+  
+  case RECORD_DRIVE_TABLE:
+    StreamPut(cbParams, sizeof(cbParams));
+    cbRecord = RECORD_TRACK;
+    return true;
+    
+  case RECORD_TRACK:
+    return WdiEncodeTrack();
+    
+  case RECORD_SECTOR:
+    return WdiEncodeSector();
+  }
+  
+  return true;
+}
+
+// physical cylinder and head, sectors per track and the sector numbering map
+bool WdiEncodeTrack()
+{
+  cbCylinder = wdc->getPhysicalCylinder();
+  cbHead = wdc->getPhysicalHead();
+  const BYTE address[3] = {(BYTE)cbCylinder, (BYTE)(cbCylinder >> 8), cbHead}; // cylinder LSB first
+  StreamPut(address, sizeof(address));
+  ui->print(Progmem::getString(Progmem::imgTrackProgress), cbCylinder, cbHead); // only with a separate data channel
+  
+  if (!wdc->seekDrive(cbCylinder, cbHead))
+  {
+    cbSuccess = false;
+    cbProgmemResponseStr = Progmem::uiFeSeek;
     return false;
   }
   
-  for(;;)
+  cbSectorsTable = NULL;
+  cbSectorsTableCount = 0;
+  
+  // SDH byte and the sectors table, scanned or from the track cache
+  BYTE sdh;
+  WD42C22::TrackGeometry geometry;
+  cbSectorsTable = ScanTrack(sdh, cbSectorsTableCount, geometry);
+  cbSpt = geometry.SectorsPerTrack;
+  
+  // WDC timeout, drive not ready, writefault
+  if (!cbSectorsTable && wdc->getLastError() && (wdc->getLastError() < 4))
   {
-    // write WDI header and comment from SRAM to output file
-    if (cbProcessingHeader)
-    {       
-      for (;;)
-      {
-        const BYTE sramByte = wdc->sramReadByteSequential();
-        data[packetIdx++] = sramByte;
+    cbSuccess = false;
+    cbProgmemResponseStr = wdc->getLastErrorMessage();
+    return false;
+  }
+  
+  // not a single valid sector ID found: unreadable
+  const bool noSectors = !cbSectorsTable && !cbSpt && (wdc->getLastError() >= 4);
+  if (!noSectors && !cbSectorsTable && !cbSectorsTableCount)
+  {
+    cbSuccess = false;
+    cbProgmemResponseStr = Progmem::uiFeMemory;
+    return false;
+  }
+  
+  if (!noSectors && cbSpt)
+  {
+    // as the interleave table almost always never starts from the beginning, find the starting sector
+    // but even the starting sector number might not start from 0
+    WORD startingSector = 0;
+    
+    while (cbStartingSectorIdx == (WORD)-1) // undefined
+    {
+      bool found = false;
+      
+      for (WORD idx = 0; idx < cbSectorsTableCount; idx++)
+      {                   
+        if (cbSectorsTable[idx] == 0xFFFFFFFFUL) // undefined?
+        {
+          continue;
+        }
         
-        if (sramByte == 0x1A)
+        // logical sector number matching?
+        if ((BYTE)(cbSectorsTable[idx] >> 16) == startingSector)
         {
-          cbProcessingHeader = false;
-          cbProcessingDriveTable = true;
-          cbLastPos = 0;
-          
-          wdc->sramFinishBufferAccess();          
+          cbStartingSectorIdx = idx;
+          cbSectorIdx = cbStartingSectorIdx;
+          found = true;
           break;
         }
-        
-        CHECK_STREAM_END;
       }
       
-      CHECK_STREAM_END;
+      if (found)
+      {
+        break;
+      }
+      
+      startingSector++;  // starts from 1, 2 or whatever
+      if (startingSector > 255) // cannot sync
+      {
+        cbSpt = 0; // mark track as unreadable
+        break;
+      }
     }
-    
-    // write DiskDriveParams to a total of 32 bytes; unused values pre-set to 0
-    if (cbProcessingDriveTable)
+  }
+  
+  StreamPut(&cbSpt, 1);
+  
+  // track contains no sectors?
+  if (!cbSpt)
+  {
+    cbUnreadableTracks++;
+    return WdiNextTrack();
+  }
+  
+  // now the sector numbering map, 4 bytes per each sector
+  BYTE mapCount = 0;
+  while (mapCount < cbSpt)
+  {
+    while ((mapCount < cbSpt) && (cbSectorIdx < cbSectorsTableCount))
     {
-      while (cbLastPos < sizeof(cbParams))
+      if (cbSectorsTable[cbSectorIdx] == 0xFFFFFFFFUL) // undefined?
       {
-        data[packetIdx++] = cbParams[cbLastPos++];
-        CHECK_STREAM_END;
+        cbSectorIdx++;
+        continue;
       }
       
-      cbLastPos = 0;
-      cbProcessingDriveTable = false;
+      cbCurrentSector = (BYTE)(cbSectorsTable[cbSectorIdx] >> 16);
+      StreamPut((const BYTE*)(&cbSectorsTable[cbSectorIdx]), sizeof(DWORD));
+      cbMapIdx[mapCount++] = (BYTE)cbSectorIdx; // remember where in the table, for the data records
+      cbSectorIdx++;
     }
     
-    // current physical cylinder
-    if (!cbCylinderSpecified)
+    // sectors per track count not reached: do we still need to go from the beginning of the table?
+    if (mapCount < cbSpt)
     {
-      cbCylinder = wdc->getPhysicalCylinder();
+      bool found = false;
+          
+      while (cbCurrentSector && !found)
+      {
+        for (cbSectorIdx = 0; cbSectorIdx < cbSectorsTableCount; cbSectorIdx++)
+        {
+          if ((((BYTE)(cbSectorsTable[cbSectorIdx] >> 16)) == cbCurrentSector) &&
+               (cbSectorsTable[cbSectorIdx] != 0xFFFFFFFFUL))
+          {
+            found = true;
+            break;
+          }
+        }
+        
+        if (!found)
+        {
+          cbCurrentSector++; // possible gap?
+        }
+      }            
       
-      if (cbLastPos == 0) // LSB
+      // found from the beginning, get the succeeding sector index
+      if (found)
       {
-        data[packetIdx++] = (BYTE)cbCylinder;
-        cbLastPos++;
-        CHECK_STREAM_END;
+        cbSectorIdx += 1;
+        if (cbSectorIdx < cbSectorsTableCount)
+        {
+          continue; // valid
+        }
       }
-      
-      data[packetIdx++] = (BYTE)(cbCylinder >> 8); // MSB
-      cbCylinderSpecified = true;
-      cbLastPos = 0;
-      CHECK_STREAM_END;
+
+      // not found or out-of-bounds
+      cbSectorIdx = 0;
+    }
+  }
+  
+  cbSectorIdx = cbStartingSectorIdx;
+  cbLastPos = 0;
+  cbCurrentSector = 0;
+  cbRecord = RECORD_SECTOR;
+  return true;
+}
+
+// data record type and the data of the sector at map position cbLastPos
+bool WdiEncodeSector()
+{
+  cbSectorIdx = cbMapIdx[cbLastPos];
+  
+  const BYTE sdh = (BYTE)(cbSectorsTable[cbSectorIdx] >> 24);        
+  cbSecSizeBytes = wdc->getSectorSizeFromSDH(sdh);        
+  cbCurrentSector = (BYTE)(cbSectorsTable[cbSectorIdx] >> 16);
+  
+  // not in the SRAM buffer yet: read the window of the track that starts here
+  if ((cbLastPos < cbBurstPos) || (cbLastPos >= cbBurstPos + cbBurstCount))
+  {
+    if (!CbReadTrackWindow())
+    {
+      cbSuccess = false;
+      cbProgmemResponseStr = wdc->getLastErrorMessage();
+      return false;
     }
     
-    // head
-    if (!cbHeadSpecified)
+    // the rest of this track is in SRAM now: the heads can travel while it goes out to the serial link
+    if ((cbBurstPos + cbBurstCount >= cbSpt) && !CbSeekNextTrack())
     {
-      cbHead = wdc->getPhysicalHead();
-      data[packetIdx++] = cbHead;
-      cbHeadSpecified = true;
-      CHECK_STREAM_END;
+      cbSuccess = false;
+      cbProgmemResponseStr = Progmem::uiFeSeek;
+      return false;
     }
+  }
+  
+  const BYTE burstSlot = (BYTE)(cbLastPos - cbBurstPos);
+  const WORD burstOffset = burstSlot * cbSecSizeBytes;
+  const BYTE status = cbBurstStatus[burstSlot];
+  
+  if (status == WDC_CORRECTED) // treat successful ECC correction as OK
+  {
+    cbSectorDataType = 1;
+    cbTotalCorrectedErrors++;
+  }
+  
+  else if (status == WDC_DATAERROR) // we have data, but likely faulty
+  {
+    cbSectorDataType = 2;
+    cbTotalDataErrors++;
+  }
+  
+  else if (status) // no data in buffer
+  {
+    cbSectorDataType = 0;
+    cbTotalBadBlocks++;
+  }
+  
+  else
+  {
+    cbSectorDataType = 1; // valid data
+  }
+  
+  // determine whether to compress the data
+  BYTE firstData = 0;
+  if (cbSectorDataType)
+  {
+    wdc->sramBeginBufferAccess(false, burstOffset);
+    bool compressedData = true;
+    BYTE chunk[32]; // sector sizes are multiples of this
     
-    // sectors per track
-    if (!cbSptSpecified)
+    for (WORD idx = 0; compressedData && (idx < cbSecSizeBytes); idx += sizeof(chunk))
     {
-      if (!wdc->seekDrive(cbCylinder, cbHead))
-      {
-        cbSuccess = false;
-        cbProgmemResponseStr = Progmem::uiFeSeek;
-        return false;
-      }
-      
-      if (cbSectorsTable)
+      wdc->sramReadBlock(chunk, sizeof(chunk));
+      wdc->applyCorrections(chunk, burstOffset + idx, sizeof(chunk));
+      if (!idx)
       {
-        delete[] cbSectorsTable;
-        cbSectorsTable = NULL;
+        firstData = chunk[0];
       }
-      cbSectorsTableCount = 0;
       
-      // get SDH byte, 5 attempts
-      BYTE sdh;
-      BYTE attempts = 5;
-      while (attempts)
+      for (BYTE chunkIdx = 0; chunkIdx < sizeof(chunk); chunkIdx++)
       {
-        WORD dummy;
-        BYTE dummy2;        
-        wdc->scanID(dummy, dummy2, sdh);
-        
-        // WDC timeout, drive not ready, writefault
-        if (wdc->getLastError())
-        {
-          if (wdc->getLastError() < 4)
-          {
-            cbSuccess = false;
-            cbProgmemResponseStr = wdc->getLastErrorMessage();
-            return false;
-          }
-          
-          attempts--;
-        }
-        else
+        if (chunk[chunkIdx] != firstData)
         {
+          compressedData = false;
           break;
         }
       }
-      
-      // no single valid sector ID found
-      if (!attempts)
-      {
-        cbSpt = 0;
-        cbSptSpecified = true;
-        data[packetIdx++] = cbSpt;
-        CHECK_STREAM_END;
-        
-        continue;
-      }      
-            
-      // now calculate SPT
-      bool dummy3;
-      cbSectorsTable = CalculateSectorsPerTrack(sdh, cbSpt, cbSectorsTableCount, dummy3, dummy3, dummy3);
-      if (!cbSectorsTable && !cbSectorsTableCount)
+    }
+    wdc->sramFinishBufferAccess();
+    
+    if (compressedData)
+    {
+      cbSectorDataType |= 0x80; //set bit 7
+    }
+  }      
+  
+  StreamPut(&cbSectorDataType, 1);
+  if (cbSectorDataType & 0x80)
+  {
+    StreamPut(&firstData, 1); // compressed data (same byte repeated secSizeBytes)
+  }
+  else if (cbSectorDataType)
+  {
+    StreamPutSram(burstOffset, cbSecSizeBytes, true);
+  }
+  
+  // next sector
+  if (++cbLastPos < cbSpt)
+  {
+    return true;
+  }
+  
+  // end of track
+  cbSuccess = true;
+  cbProgmemResponseStr = 0;
+  
+  // how many revolutions it took to read, in 1/100s
+  if (wdc->getSectorPeriod())
+  {
+    cbRevolutions += (cbTrackReadMicros * 100) / ((DWORD)cbSpt * wdc->getSectorPeriod());
+    cbTracksRead++;
+  }
+  cbTrackReadMicros = 0;
+  
+  return WdiNextTrack();
+}
+
+// on to the next track in the traversal order, or the end of the image
+bool WdiNextTrack()
+{
+  cbLastPos = 0;
+  cbSectorIdx = 0;
+  cbCurrentSector = 0;
+  cbStartingSectorIdx = (WORD)-1;
+  cbBurstCount = 0;
+  
+  if (!TraversalNext(cbTraversal))
+  {
+    cbSuccess = true;
+    cbProgmemResponseStr = 0;
+    cbRecord = RECORD_DONE;
+    return true;
+  }
+  
+  // normally already on its way, see CbSeekNextTrack()
+  cbCylinder = cbTraversal.Cylinder;
+  cbHead = cbTraversal.Head;
+  if (!wdc->seekStart(cbCylinder, cbHead))
+  {
+    cbSuccess = false;
+    cbProgmemResponseStr = Progmem::uiFeSeek;
+    return false;
+  }
+  
+  cbRecord = RECORD_TRACK;
+  return true;
+}
+
+// read the next window of the current track into SRAM, starting at map position cbLastPos:
+// the following sectors of the same size, as many as the buffer holds, each into its own slot
+// a run of logically consecutive sectors (1:1 interleave) goes in one read multisector command;
+// otherwise the sectors are read one by one, in the order they pass under the head, beginning with the one after the last scanned ID
+bool CbReadTrackWindow()
+{
+  const DWORD startMicros = micros();
+  const DWORD firstEntry = cbSectorsTable[cbMapIdx[cbLastPos]];
+  const BYTE maxCount = (BYTE)(2048 / cbSecSizeBytes);
+  
+  BYTE count = 1;
+  bool consecutive = true;
+  while ((count < maxCount) && (cbLastPos + count < cbSpt))
+  {
+    const DWORD entry = cbSectorsTable[cbMapIdx[cbLastPos + count]];
+    if ((BYTE)(entry >> 24) != (BYTE)(firstEntry >> 24)) // sector size or head differs
+    {
+      break;
+    }
+    if (entry != firstEntry + ((DWORD)count << 16))
+    {
+      consecutive = false;
+    }
+    count++;
+  }
+  
+  cbBurstPos = cbLastPos;
+  cbBurstCount = count;
+  wdc->sramDiscardBuffer(); // the previous window went out already
+  
+  if (consecutive)
+  {
+    // if the head is within the window, start there, the slots stay in map order
+    BYTE firstIndex = 0;
+#if TRACK_READ_ZERO_LATENCY
+    if (count > 1)
+    {
+      WORD cylinder;
+      BYTE sector;
+      BYTE sdh;
+      wdc->scanID(cylinder, sector, sdh);
+      if (wdc->getLastError() && (wdc->getLastError() < 4))
       {
-        cbSuccess = false;
-        cbProgmemResponseStr = Progmem::uiFeMemory;
         return false;
       }
-      
-      if (cbSpt)
+      if (!wdc->getLastError())
       {
-        // as the interleave table almost always never starts from the beginning, find the starting sector
-        // but even the starting sector number might not start from 0
-        WORD startingSector = 0;
-        
-        while (cbStartingSectorIdx == (WORD)-1) // undefined
+        const DWORD scanned = ((DWORD)sdh << 24) | ((DWORD)sector << 16) | cylinder;
+        for (WORD pos = 0; pos < cbSpt; pos++)
         {
-          bool found = false;
-          
-          for (WORD idx = 0; idx < cbSectorsTableCount; idx++)
-          {                   
-            if (cbSectorsTable[idx] == 0xFFFFFFFFUL) // undefined?
-            {
-              continue;
-            }
-            
-            // logical sector number matching?
-            if ((BYTE)(cbSectorsTable[idx] >> 16) == startingSector)
+          if (cbSectorsTable[cbMapIdx[pos]] == scanned)
+          {
+            const WORD next = (pos + 1 + TRACK_READ_SKIP) % cbSpt;
+            if ((next > cbLastPos) && (next < cbLastPos + count))
             {
-              cbStartingSectorIdx = idx;
-              cbSectorIdx = cbStartingSectorIdx;
-              cbLastPos = 0; // use this as count how many were written in the map
-              found = true;
-              break;
+              firstIndex = (BYTE)(next - cbLastPos);
             }
-          }
-          
-          if (found)
-          {
-            break;
-          }
-          
-          startingSector++;  // starts from 1, 2 or whatever
-          if (startingSector > 255) // cannot sync
-          {
-            cbSpt = 0; // mark track as unreadable
             break;
           }
         }
       }
- 
-      cbSptSpecified = true;
-      data[packetIdx++] = cbSpt;
-      CHECK_STREAM_END;
     }
+#endif
     
-    // track contains no sectors?
-    if (!cbSpt)
+    const BYTE logicalHead = (BYTE)(firstEntry >> 24) & 0xF;
+    const WORD logicalCylinder = (WORD)firstEntry;
+    wdc->readSectors((BYTE)(firstEntry >> 16), count, cbSecSizeBytes, &logicalCylinder, &logicalHead, firstIndex);
+    if (wdc->getLastError() && (wdc->getLastError() < 4)) // WDC timeout, drive not ready, writefault
     {
-      cbUnreadableTracks++;
-      
-      // re-specify
-      cbCylinderSpecified = false;
-      cbHeadSpecified = false;
-      cbSptSpecified = false;
-      cbSecMapSpecified = false;
-      cbLastPos = 0;
-      cbSectorIdx = 0;
-      cbStartingSectorIdx = (WORD)-1;
-      
-      // seek to the next
-      cbHead++;
-      if (cbHead == wdc->getParams()->Heads)
-      {
-        cbHead = 0;
-        cbCylinder++;
-      }
-      if ((cbCylinder == wdc->getParams()->Cylinders) ||
-          (wdc->getParams()->PartialImage && (cbCylinder-1 == wdc->getParams()->PartialImageEndCyl)))
-      {
-        cbSuccess = true;
-        cbProgmemResponseStr = 0;
-        return true; // flush the buffer
-      }
-      
-      if (!wdc->seekDrive(cbCylinder, cbHead))
-      {
-        cbSuccess = false;
-        cbProgmemResponseStr = Progmem::uiFeSeek;
-        return false;
-      }
-      
-      continue; // transfer continues
+      return false;
     }
     
-    // sector numbering map
-    if (!cbSecMapSpecified)
+    for (BYTE slot = 0; slot < count; slot++)
     {
-      static BYTE sectorMapPos = 0;      
-      
-      // now write the sector numbering map
-      while ((cbLastPos < (WORD)cbSpt*4) && (cbSectorIdx < cbSectorsTableCount))
-      {
-        if (cbSectorsTable[cbSectorIdx] == 0xFFFFFFFFUL) // undefined?
-        {
-          cbSectorIdx++;
-          sectorMapPos = 0;
-          continue;
-        }
-        
-        cbCurrentSector = (BYTE)(cbSectorsTable[cbSectorIdx] >> 16);
-        
-        const BYTE* sectorMap = (const BYTE*)(&cbSectorsTable[cbSectorIdx]); // access by bytes
-        data[packetIdx++] = sectorMap[sectorMapPos++];
-        
-        cbLastPos++;
-        if ((cbLastPos % 4) == 0)
-        {
-          cbSectorIdx++; // 4 bytes per each sector
-          sectorMapPos = 0;
-        }
-        CHECK_STREAM_END;       
-      }
-      
-      // sectors per track count not reached: do we still need to go from the beginning of the table?
-      if ((cbSectorIdx == cbSectorsTableCount) && (cbLastPos < (WORD)cbSpt*4))
+      cbBurstStatus[slot] = wdc->getSectorStatus(slot);
+    }
+  }
+  else
+  {
+    // where is the head now? if not known, act as if the window start is the nearest
+    WORD headPos = (cbLastPos + (cbSpt - 1 - TRACK_READ_SKIP)) % cbSpt;
+    
+    WORD cylinder;
+    BYTE sector;
+    BYTE sdh;
+    wdc->scanID(cylinder, sector, sdh);
+    if (wdc->getLastError() && (wdc->getLastError() < 4))
+    {
+      return false;
+    }
+    if (!wdc->getLastError())
+    {
+      const DWORD scanned = ((DWORD)sdh << 24) | ((DWORD)sector << 16) | cylinder;
+      for (WORD pos = 0; pos < cbSpt; pos++)
       {
-        sectorMapPos = 0;
-        bool found = false;
-            
-        while (cbCurrentSector && !found)
-        {
-          for (cbSectorIdx = 0; cbSectorIdx < cbSectorsTableCount; cbSectorIdx++)
-          {
-            if ((((BYTE)(cbSectorsTable[cbSectorIdx] >> 16)) == cbCurrentSector) &&
-                 (cbSectorsTable[cbSectorIdx] != 0xFFFFFFFFUL))
-            {
-              found = true;
-              break;
-            }
-          }
-          
-          if (!found)
-          {
-            cbCurrentSector++; // possible gap?
-          }
-        }            
-        
-        // found from the beginning, get the succeeding sector index
-        if (found)
+        if (cbSectorsTable[cbMapIdx[pos]] == scanned)
         {
-          cbSectorIdx += 1;
-          if (cbSectorIdx < cbSectorsTableCount)
-          {
-            continue; // valid
-          }
+          headPos = pos;
+          break;
         }
-
-        // not found or out-of-bounds
-        cbSectorIdx = 0;
-        continue;
       }
-      
-      cbSectorIdx = cbStartingSectorIdx;
-      cbLastPos = 0;
-      sectorMapPos = 0;
-      cbCurrentSector = 0;
-      cbSecMapSpecified = true;
     }
     
-    // now try to read    
-    while ((cbLastPos < cbSpt) && (cbSectorIdx < cbSectorsTableCount))
-    {     
-      static WORD rwBufferPos = 0;
-      
-      if (!cbSecDataTypeSpecified) // determine data record type
+    DWORD unread = (1UL << count) - 1;
+    while (unread)
+    {
+      // nearest sector still to be read, that can be caught after the one just passed
+      BYTE slot = 0;
+      WORD nearest = 0xFFFF;
+      for (BYTE idx = 0; idx < count; idx++)
       {
-        rwBufferPos = 0;
-        
-        if (cbSectorsTable[cbSectorIdx] == 0xFFFFFFFFUL) // skip undefined
+        if (!(unread & (1UL << idx)))
         {
-          cbSectorIdx++;
           continue;
         }
         
-        const BYTE sdh = (BYTE)(cbSectorsTable[cbSectorIdx] >> 24);        
-        cbSecSizeBytes = wdc->getSectorSizeFromSDH(sdh);        
-        
-        const BYTE logicalSector = (BYTE)(cbSectorsTable[cbSectorIdx] >> 16);
-        cbCurrentSector = logicalSector;
-        const WORD logicalCylinder = (WORD)cbSectorsTable[cbSectorIdx];
-        const BYTE logicalHead = sdh & 0xF;        
-        
-        wdc->readSector(logicalSector, cbSecSizeBytes, false, &logicalCylinder, &logicalHead);     
-        if (wdc->getLastError())
-        {
-          if (wdc->getLastError() < 4) // WDC timeout, drive not ready, writefault
-          {
-            cbSuccess = false;
-            cbProgmemResponseStr = wdc->getLastErrorMessage();
-            return false;
-          }
-          
-          else if (wdc->getLastError() == WDC_CORRECTED) // treat successful ECC correction as OK
-          {
-            cbSectorDataType = 1;
-            cbTotalCorrectedErrors++;
-          }
-        
-          else if (wdc->getLastError() == WDC_DATAERROR) // we have data, but likely faulty
-          {
-            cbSectorDataType = 2;
-            cbTotalDataErrors++;
-          }
-          
-          else // no data in buffer
-          {
-            cbSectorDataType = 0;
-            cbTotalBadBlocks++;
-          }
-        }
-        else
+        WORD distance = (cbLastPos + idx + cbSpt - headPos) % cbSpt;
+        if (distance <= TRACK_READ_SKIP)
         {
-          cbSectorDataType = 1; // valid data
+          distance += cbSpt; // next revolution
         }
-        
-        // determine whether to compress the data
-        if (cbSectorDataType)
+        if (distance < nearest)
         {
-          wdc->sramBeginBufferAccess(false, 0);
-          bool compressedData = true;
-          BYTE lastData = wdc->sramReadByteSequential();
-          
-          for (WORD idx = 1; idx < cbSecSizeBytes; idx++)
-          {
-            const BYTE currData = wdc->sramReadByteSequential();
-            if (currData != lastData)
-            {
-              compressedData = false;
-              break;
-            }
-            lastData = currData;
-          }
-          
-          if (compressedData)
-          {
-            cbSectorDataType |= 0x80; //set bit 7
-          }
-          
-          wdc->sramBeginBufferAccess(false, 0); // rewind SRAM buffer          
-        }      
-        
-        data[packetIdx++] = cbSectorDataType; 
-        cbSecDataTypeSpecified = true;
-        CHECK_STREAM_END;
-      }
-                
-      // data is ready
-      switch(cbSectorDataType)
-      {
-      case 1:
-      case 2:      
-      {
-        while (rwBufferPos != cbSecSizeBytes)
-        {
-          data[packetIdx++] = wdc->sramReadByteSequential();
-          rwBufferPos++;
-          CHECK_STREAM_END;
+          nearest = distance;
+          slot = idx;
         }
-        rwBufferPos = 0;
-        wdc->sramFinishBufferAccess();
-      }
-      break;
-      case 0x81:
-      case 0x82:      
-      {
-        // compressed data (same byte repeated secSizeBytes)
-        data[packetIdx++] = wdc->sramReadByteSequential();
-        wdc->sramFinishBufferAccess();
-        cbSectorDataType = 0; // go to next sector
-        CHECK_STREAM_END;
-      }
-      break;
       }
       
-      // next sector
-      cbSectorIdx++;
-      cbLastPos++;
-      cbSecDataTypeSpecified = false;
-    }    
-    if ((cbSectorIdx == cbSectorsTableCount) && (cbLastPos < cbSpt))
-    {
-      bool found = false;
-            
-      while (cbCurrentSector && !found)
+      const DWORD entry = cbSectorsTable[cbMapIdx[cbLastPos + slot]];
+      const BYTE logicalHead = (BYTE)(entry >> 24) & 0xF;
+      const WORD logicalCylinder = (WORD)entry;
+      wdc->readSector((BYTE)(entry >> 16), cbSecSizeBytes, false, &logicalCylinder, &logicalHead, slot * cbSecSizeBytes);
+      if (wdc->getLastError() && (wdc->getLastError() < 4))
       {
-        for (cbSectorIdx = 0; cbSectorIdx < cbSectorsTableCount; cbSectorIdx++)
-        {
-          if ((((BYTE)(cbSectorsTable[cbSectorIdx] >> 16)) == cbCurrentSector) &&
-               (cbSectorsTable[cbSectorIdx] != 0xFFFFFFFFUL))
-          {
-            found = true;
-            break;
-          }
-        }
-        
-        if (!found)
-        {
-          cbCurrentSector++;
-        }
-      }            
-      
-      if (found)
-      {
-        cbSectorIdx += 1;
-        if (cbSectorIdx < cbSectorsTableCount)
-        {
-          continue;
-        }
+        return false;
       }
       
-      cbSectorIdx = 0;
-      continue;
-    }
-       
-    // end of track?
-    cbSuccess = true;
-    cbProgmemResponseStr = 0;
-
-    // re-specify
-    cbCylinderSpecified = false;
-    cbHeadSpecified = false;
-    cbSptSpecified = false;
-    cbSecMapSpecified = false;
-    cbSecDataTypeSpecified = false;
-    cbLastPos = 0;
-    cbSectorIdx = 0;
-    cbCurrentSector = 0;
-    cbStartingSectorIdx = (WORD)-1;   
-    
-    // and seek to next
-    cbHead++;
-    if (cbHead == wdc->getParams()->Heads)
-    {
-      cbHead = 0;
-      cbCylinder++;
-    }
-    if ((cbCylinder == wdc->getParams()->Cylinders) ||    
-        (wdc->getParams()->PartialImage && (cbCylinder-1 == wdc->getParams()->PartialImageEndCyl)))
-    {
-      cbSuccess = true;
-      cbProgmemResponseStr = 0;
-      return true; // flush the buffer
+      cbBurstStatus[slot] = wdc->getLastError();
+      unread &= ~(1UL << slot);
+      headPos = cbLastPos + slot;
     }
+  }
+  
+  cbTrackReadMicros += micros() - startMicros;
+  return true;
+}
 
-    if (!wdc->seekDrive(cbCylinder, cbHead))
-    {
-      cbSuccess = false;
-      cbProgmemResponseStr = Progmem::uiFeSeek;
-      return false;
-    } 
+// start seeking to the track that follows in the traversal order, without waiting for the heads to settle:
+// seekDrive() before scanning it does, no WDC commands are issued in the meantime
+bool CbSeekNextTrack()
+{
+  WORD cylinder;
+  BYTE head;
+  if (!TraversalPeek(cbTraversal, cylinder, head))
+  {
+    return true; // last one
   }
   
-  return false;   
+  return wdc->seekStart(cylinder, head);
 }
 
 // write disk callback
@@ -1157,11 +1373,7 @@ bool CbWriteDisk(DWORD packetNo, BYTE* data, WORD size)
     // current physical cylinder
     if (!cbCylinderSpecified)
     {     
-      if (cbSectorsTable) // next?
-      {
-        delete[] cbSectorsTable;
-        cbSectorsTable = NULL;
-      }
+      cbSectorsTable = NULL;
       
       if (cbLastPos == 0) // LSB
       {
@@ -1236,13 +1448,14 @@ bool CbWriteDisk(DWORD packetNo, BYTE* data, WORD size)
     {
       if (!cbSectorsTable)
       {
-        cbSectorsTable = new DWORD[cbSpt];
-        if (!cbSectorsTable)
+        // both pool tables in a row, setBadSector() uses the scratch area
+        if (cbSpt > POOL_TABLE_ENTRIES*POOL_TABLES)
         {
           cbSuccess = false;
-          cbProgmemResponseStr = Progmem::uiFeMemory;
+          cbProgmemResponseStr = Progmem::imgXmodemErrSpt;
           return false;
-        }  
+        }
+        cbSectorsTable = PoolGetTable(0);
       }
 
       // address by bytes
@@ -1306,6 +1519,7 @@ bool CbWriteDisk(DWORD packetNo, BYTE* data, WORD size)
       wdc->sramFinishBufferAccess();
       
       // prepare for writing, seek the drive
+      ui->print(Progmem::getString(Progmem::imgTrackProgress), cbCylinder, cbHead);
       if (!wdc->seekDrive(cbCylinder, cbHead))
       {
         cbSuccess = false;
@@ -1414,10 +1628,7 @@ bool CbWriteDisk(DWORD packetNo, BYTE* data, WORD size)
           
           if (!doNotWrite)
           {
-            for (WORD index = 0; index < cbSecSizeBytes; index++)
-            {
-              wdc->sramWriteByteSequential(compressed);
-            }            
+            wdc->sramFillBlock(compressed, cbSecSizeBytes);
           }
           
           wdc->sramFinishBufferAccess();          
@@ -1428,13 +1639,20 @@ bool CbWriteDisk(DWORD packetNo, BYTE* data, WORD size)
         {
           while (cbLastPos != cbSecSizeBytes)
           {
-            BYTE byte = data[packetIdx++];
+            // burst as much of the sector as this packet holds
+            WORD count = cbSecSizeBytes - cbLastPos;
+            if (count > size - packetIdx)
+            {
+              count = size - packetIdx;
+            }
+            
             if (!doNotWrite)
             {
-              wdc->sramWriteByteSequential(byte);
+              wdc->sramWriteBlock(&data[packetIdx], count);
             }
             
-            cbLastPos++;            
+            packetIdx += count;
+            cbLastPos += count;            
             CHECK_STREAM_END;
           }
           wdc->sramFinishBufferAccess();
@@ -1562,6 +1780,10 @@ bool CbVerifyParamsFromImage()
   {
     return false;
   }
+  if (params->SeekProfile > SEEK_PROFILE_BURST)
+  {
+    return false;
+  }
   
   // "-1" or 65535 not considered as valid as these are turned on or off via a flag
   if ((params->WritePrecompStartCyl > 2048) || 
@@ -17,6 +17,7 @@ void CommandScan();
 void CommandShowParams();
 void CommandSeekTest();
 void CommandPark();
+void CommandRotation();
 // declared in image.h
 //void CommandReadImage();
 //void CommandWriteImage();
@@ -51,6 +52,7 @@ void InitializeDisk()
   wdc->recalibrate();
   ui->print(" ");
   ui->print(Progmem::getString(Progmem::uiOK));
+  ui->print(Progmem::getString(Progmem::uiRecalibrateTime), wdc->getRecalibrateTime());
   ui->print(Progmem::getString(Progmem::uiNewLine));
   
   // we can continue, setup and apply new parameters
@@ -70,8 +72,8 @@ void MainLoop()
   }
    
   // main menu
-  char allowedKeys[11] = {0};
-  strcat(allowedKeys, "AHFMRWSI");
+  char allowedKeys[12] = {0};
+  strcat(allowedKeys, "AHFMRWSIT");
   if (wdc->getParams()->Cylinders >= 10)
   {
     strcat(allowedKeys, "D"); // offer seek test command
@@ -83,9 +85,9 @@ void MainLoop()
   
   for (;;)
   {
-    // make sure we're at cylinder 0 after any operation
+    // make sure we're at the parking point after any operation
     ui->print("");    
-    wdc->seekDrive(0, 0);
+    wdc->seekDrive(TraversalHome(), 0);
     wdc->selectDrive(false); // not needed during command specifications
     
     ui->print(Progmem::getString(Progmem::optionAnalyze));
@@ -96,6 +98,7 @@ void MainLoop()
     ui->print(Progmem::getString(Progmem::optionWriteImage));
     ui->print(Progmem::getString(Progmem::optionShowParams));
     ui->print(Progmem::getString(Progmem::optionDos));
+    ui->print(Progmem::getString(Progmem::optionRotation));
     if (wdc->getParams()->Cylinders >= 10)
     {
       ui->print(Progmem::getString(Progmem::optionSeektest));
@@ -137,6 +140,9 @@ void MainLoop()
     case 'I':
       CommandDos();
       break;
+    case 'T':
+      CommandRotation();
+      break;
     case 'D':
       CommandSeekTest();
       break;
@@ -362,6 +368,12 @@ void SetupParameters()
   wdc->getParams()->SlowSeek = (key == 'S');
   ui->print(Progmem::getString(Progmem::uiEchoKey), key);
   
+  // and how the step pulses are spaced
+  ui->print(Progmem::getString(Progmem::uiSetupAskProfile));
+  key = toupper(ui->readKey("CRB"));
+  wdc->getParams()->SeekProfile = (key == 'R') ? SEEK_PROFILE_RAMPED : (key == 'B') ? SEEK_PROFILE_BURST : SEEK_PROFILE_CONSTANT;
+  ui->print(Progmem::getString(Progmem::uiEchoKey), key);
+  
   // later for disk image purposes
   wdc->getParams()->PartialImage = false;
   wdc->getParams()->PartialImageStartCyl = 0;
@@ -504,226 +516,192 @@ void CommandAnalyze()
   bool cylinderMismatch = false;  
   bool variableSectorSize = false;  
   
-  for (WORD cylinder = startCylinder; cylinder <= endCylinder; cylinder++)
+  // all tracks of the range, in the traversal order
+  Traversal traversal;
+  TraversalBegin(traversal, startCylinder, endCylinder);
+  do
   {
+    const WORD cylinder = traversal.Cylinder;
+    const BYTE head = traversal.Head;
+    
+    // scanID first, up to 5 attempts, then the sectors table; or from the track cache
+    wdc->seekDrive(cylinder, head);
+    
+    BYTE sdh;
+    WORD tableCount = 0;
+    WD42C22::TrackGeometry geometry;
+    DWORD* sectorsTable = ScanTrack(sdh, tableCount, geometry);
+    const BYTE sectorsPerTrack = geometry.SectorsPerTrack;
+    
+    const bool thisVariableSectorSize = geometry.Flags & TRACK_VARIABLE_SIZE;    // flag to show "variable bytes" in the following status message
+    const bool thisHeadMismatch = geometry.Flags & TRACK_HEAD_MISMATCH;          // show "@" at the end of line
+    const bool thisCylinderMismatch = geometry.Flags & TRACK_CYLINDER_MISMATCH;  // "*"
+    
+    // first three (WDC timeout, drive not ready, writefault) abort the command
+    if (!sectorsTable && wdc->getLastError() && (wdc->getLastError() < 4))
+    {
+      ui->print(Progmem::getString(Progmem::uiNewLine));
+      ui->print(Progmem::getString(wdc->getLastErrorMessage()));
+      ui->print(Progmem::getString(Progmem::uiNewLine));
+      return;        
+    }
+    
+    // no single valid sector ID found
+    if (!sectorsPerTrack)
+    {
+      ui->print(Progmem::getString(Progmem::uiCHInfo), cylinder, head);
+      ui->print(Progmem::getString(Progmem::analyzeNoSectors));
+      continue;
+    }
+          
+    // "global" flags to fire a warning in the end, when we're done with the read
+    // "local" flags - indicate with a symbol character to the current line
+    diskNotEmpty |= true;
+    variableSectorSize |= thisVariableSectorSize; 
+    headMismatch |= thisHeadMismatch;
+    cylinderMismatch |= thisCylinderMismatch;
+    
+    const WORD sectorSize = wdc->getSectorSizeFromSDH(sdh);
+    const BYTE interleave = geometry.Interleave;
+    const bool interleaveKnown = (interleave != 0);
+    
+    // print out info
+    ui->print(Progmem::getString(Progmem::uiCHInfo), cylinder, head);
+    if (!thisVariableSectorSize)
+    {
+      ui->print(Progmem::getString(Progmem::analyzeSectorInfo), sectorsPerTrack, sectorSize);  
+    }
+    else
+    {
+      ui->print(Progmem::getString(Progmem::analyzeSectorInfo2), sectorsPerTrack);
+    }
+    
+    // interleave
+    if (interleaveKnown)
+    {
+      ui->print("%u:1", interleave);
+    }
+    else
+    {
+      ui->print(Progmem::getString(Progmem::analyzeSectorInfo3));
+    }
+    ui->print(Progmem::getString(Progmem::analyzeSectorInfo4));
 
-    // for all heads
-    BYTE head = 0;
-    while (head < wdc->getParams()->Heads)
-    {   
-      // execute scanID first, up to 5 attempts
-      wdc->seekDrive(cylinder, head);
-
-      BYTE sdh;
-      BYTE attempts = 5;      
-      while (attempts)
+    // append special characters to the line
+    if (thisCylinderMismatch || thisHeadMismatch)
+    {
+      ui->print(" ");
+      if (thisCylinderMismatch)      
+      {
+        ui->print("*");
+      }
+      if (thisHeadMismatch)
+      {
+        ui->print("@");
+      }        
+    }
+    
+    // sectors numbering
+    if (sectorNumberings)
+    {
+      WORD startingSector = 0;
+      WORD idx = 0;
+      
+      for (;;)
       {
-        WORD dummy;
-        BYTE dummy2;        
-        wdc->scanID(dummy, dummy2, sdh);
+        bool found = false;
         
-        // first three (WDC timeout, drive not ready, writefault) abort the command
-        if (wdc->getLastError())
-        {
-          if (wdc->getLastError() < 4)
+        for (idx = 0; idx < tableCount; idx++)
+        {                   
+          if (sectorsTable[idx] == 0xFFFFFFFFUL)
           {
-            ui->print(Progmem::getString(Progmem::uiNewLine));
-            ui->print(Progmem::getString(wdc->getLastErrorMessage()));
-            ui->print(Progmem::getString(Progmem::uiNewLine));
-            return;        
+            continue;
           }
           
-          attempts--;
+          // logical sector number matching?
+          if ((BYTE)(sectorsTable[idx] >> 16) == startingSector)
+          {
+            found = true;
+            break;
+          }
         }
-        else
+        
+        if (found)
         {
           break;
         }
-      }
-      
-      // no single valid sector ID found
-      if (!attempts)
-      {
-        ui->print(Progmem::getString(Progmem::uiCHInfo), cylinder, head);
-        ui->print(Progmem::getString(Progmem::analyzeNoSectors));
-        head++;
-        continue;
-      }   
-      
-      bool thisVariableSectorSize = false; // flag to show "variable bytes" in the following status message
-      bool thisHeadMismatch = false;       // show "@" at the end of line
-      bool thisCylinderMismatch = false;   // "*"
-      
-      WORD tableCount = 0;
-      BYTE sectorsPerTrack = 0;
-      DWORD* sectorsTable = CalculateSectorsPerTrack(sdh, sectorsPerTrack, tableCount,
-                                                     thisHeadMismatch, thisCylinderMismatch, thisVariableSectorSize);
-      if (!sectorsPerTrack)
-      {
-        ui->print(Progmem::getString(Progmem::uiCHInfo), cylinder, head);
-        ui->print(Progmem::getString(Progmem::analyzeNoSectors));
-        if (sectorsTable)
+        
+        startingSector++;  // starts from 1, 2 or whatever
+        if (startingSector > 255) // cannot sync
         {
-          delete[] sectorsTable;
+          break;
         }
-        
-        head++;
-        continue;
-      }
-            
-      // "global" flags to fire a warning in the end, when we're done with the read
-      // "local" flags - indicate with a symbol character to the current line
-      diskNotEmpty |= true;
-      variableSectorSize |= thisVariableSectorSize; 
-      headMismatch |= thisHeadMismatch;
-      cylinderMismatch |= thisCylinderMismatch;
-      
-      const WORD sectorSize = wdc->getSectorSizeFromSDH(sdh);
-      BYTE interleave;
-      const bool interleaveKnown = CalculateInterleave(sectorsTable, tableCount, sectorsPerTrack, interleave);
-      
-      // print out info
-      ui->print(Progmem::getString(Progmem::uiCHInfo), cylinder, head);
-      if (!thisVariableSectorSize)
-      {
-        ui->print(Progmem::getString(Progmem::analyzeSectorInfo), sectorsPerTrack, sectorSize);  
-      }
-      else
-      {
-        ui->print(Progmem::getString(Progmem::analyzeSectorInfo2), sectorsPerTrack);
       }
       
-      // interleave
-      if (interleaveKnown)
-      {
-        ui->print("%u:1", interleave);
-      }
-      else
+      if (startingSector > 255)
       {
-        ui->print(Progmem::getString(Progmem::analyzeSectorInfo3));
+        // don't write sector numbering
+        continue;
       }
-      ui->print(Progmem::getString(Progmem::analyzeSectorInfo4));
 
-      // append special characters to the line
-      if (thisCylinderMismatch || thisHeadMismatch)
+      ui->print(Progmem::getString(Progmem::analyzeSectorInfo5));
+      
+      WORD idx2 = 0;
+      while (idx2 < sectorsPerTrack)
       {
-        ui->print(" ");
-        if (thisCylinderMismatch)      
+        BYTE currentSector = 0;        
+        while ((idx < tableCount) && (idx2 < sectorsPerTrack))
         {
-          ui->print("*");
+          if (sectorsTable[idx] == 0xFFFFFFFFUL) // undefined?
+          {
+            idx++;
+            continue;
+          }
+          
+          currentSector = (BYTE)(sectorsTable[idx++] >> 16);            
+          ui->print("%u ", currentSector);
+          idx2++;
         }
-        if (thisHeadMismatch)
-        {
-          ui->print("@");
-        }        
-      }
-      
-      // sectors numbering
-      if (sectorNumberings)
-      {
-        WORD startingSector = 0;
-        WORD idx = 0;
         
-        for (;;)
+        // sectors per track count not reached: do we still need to go from the beginning of the table?
+        if (idx == tableCount)
         {
           bool found = false;
           
-          for (idx = 0; idx < tableCount; idx++)
-          {                   
-            if (sectorsTable[idx] == 0xFFFFFFFFUL)
+          while (currentSector && !found)
+          {
+            for (idx = 0; idx < tableCount; idx++)
             {
-              continue;
+              if (((BYTE)(sectorsTable[idx] >> 16)) == currentSector)
+              {
+                found = true;
+                break;
+              }
             }
             
-            // logical sector number matching?
-            if ((BYTE)(sectorsTable[idx] >> 16) == startingSector)
+            if (!found)
             {
-              found = true;
-              break;
+              currentSector++; // possible gap?
             }
-          }
+          }            
           
+          // found from the beginning, get the succeeding sector index
           if (found)
           {
-            break;
-          }
-          
-          startingSector++;  // starts from 1, 2 or whatever
-          if (startingSector > 255) // cannot sync
-          {
-            break;
-          }
-        }
-        
-        if (startingSector > 255)
-        {
-          // don't write sector numbering
-          delete[] sectorsTable;
-          head++;
-          continue;
-        }
-
-        ui->print(Progmem::getString(Progmem::analyzeSectorInfo5));
-        
-        WORD idx2 = 0;
-        while (idx2 < sectorsPerTrack)
-        {
-          BYTE currentSector = 0;        
-          while ((idx < tableCount) && (idx2 < sectorsPerTrack))
-          {
-            if (sectorsTable[idx] == 0xFFFFFFFFUL) // undefined?
+            idx += 1;
+            if (idx < tableCount)
             {
-              idx++;
-              continue;
+              continue; // valid
             }
-            
-            currentSector = (BYTE)(sectorsTable[idx++] >> 16);            
-            ui->print("%u ", currentSector);
-            idx2++;
           }
-          
-          // sectors per track count not reached: do we still need to go from the beginning of the table?
-          if (idx == tableCount)
-          {
-            bool found = false;
-            
-            while (currentSector && !found)
-            {
-              for (idx = 0; idx < tableCount; idx++)
-              {
-                if (((BYTE)(sectorsTable[idx] >> 16)) == currentSector)
-                {
-                  found = true;
-                  break;
-                }
-              }
-              
-              if (!found)
-              {
-                currentSector++; // possible gap?
-              }
-            }            
-            
-            // found from the beginning, get the succeeding sector index
-            if (found)
-            {
-              idx += 1;
-              if (idx < tableCount)
-              {
-                continue; // valid
-              }
-            }
 
-            // not found, or out-of-bounds
-            break;
-          }
+          // not found, or out-of-bounds
+          break;
         }
-      }      
-                
-      delete[] sectorsTable;
-      head++;
-    }    
+      }
+    }      
   }
+  while (TraversalNext(traversal));
 
   ui->print(Progmem::getString(Progmem::uiNewLine2x));
   
@@ -902,9 +880,14 @@ void CommandHexdump()
     ui->print(Progmem::getString(Progmem::hexdumpDump));
     
     wdc->sramBeginBufferAccess(false, 0);
-    for (WORD index = 0; index < sectorSizeBytes; index++)
+    BYTE row[16];
+    for (WORD index = 0; index < sectorSizeBytes; index += sizeof(row))
     {
-      ui->print("%02X ", wdc->sramReadByteSequential());
+      wdc->sramReadBlock(row, sizeof(row));
+      for (BYTE rowIdx = 0; rowIdx < sizeof(row); rowIdx++)
+      {
+        ui->print("%02X ", row[rowIdx]);
+      }
     }
     ui->print(Progmem::getString(Progmem::uiNewLine));
     
@@ -961,6 +944,182 @@ void CommandHexdump()
   }
 }
 
+// interleave benchmark: formats one track with each interleave 1..maxInterleave, then reads it
+// sector by sector in logical order, as the hexdump or DOS (FatFs) commands do, each sector moved out of the SRAM;
+// toSerial also models the image transfer link (not sent, the terminal is in use): each sector is queued to a transmit ring
+// of POOL_TX_RING_SIZE that the data channel drains at its baud rate meanwhile, waiting only while it would not fit
+// returns the interleave with the highest throughput, 0 on a controller or drive error
+#define BENCH_PASSES  2 // logical passes over the track for each interleave
+
+BYTE BenchmarkInterleave(WORD cylinder, BYTE sectorsPerTrack, WORD sectorSizeBytes, BYTE maxInterleave, bool toSerial)
+{
+  // microseconds on the wire for one sector, 10 bits each byte; and how much can be queued ahead of the line
+#if DATA_CHANNEL_STRIPE
+  const DWORD serialMicros = toSerial ? ((DWORD)sectorSizeBytes * 10 * 1000) / (ui->getBaudRate(PORT_DATA) / 1000) / 2 : 0;
+#else
+  const DWORD serialMicros = toSerial ? ((DWORD)sectorSizeBytes * 10 * 1000) / (ui->getBaudRate(PORT_DATA) / 1000) : 0;
+#endif
+  const DWORD maxBacklog = ((DWORD)(POOL_TX_RING_SIZE - sectorSizeBytes) * serialMicros) / sectorSizeBytes;
+  const DWORD totalBytes = (DWORD)sectorSizeBytes * sectorsPerTrack * BENCH_PASSES;
+  
+  BYTE bestInterleave = 1;
+  DWORD bestRate = 0;
+  for (BYTE interleave = 1; interleave <= maxInterleave; interleave++)
+  {
+    wdc->prepareFormatInterleave(sectorsPerTrack, interleave, 1);
+    wdc->seekDrive(cylinder, 0);
+    wdc->formatTrack(sectorsPerTrack, sectorSizeBytes);
+    if (wdc->getLastError())
+    {
+      ui->print(Progmem::getString(Progmem::uiNewLine2x));
+      ui->print(Progmem::getString(wdc->getLastErrorMessage()));
+      ui->print(Progmem::getString(Progmem::uiNewLine));
+      return 0;
+    }
+    
+    WORD errors = 0;
+    const DWORD timeStart = micros();
+    DWORD lineFreeAt = timeStart; // when the line has sent all that was queued
+    for (BYTE pass = 0; pass < BENCH_PASSES; pass++)
+    {
+      for (BYTE sector = 1; sector <= sectorsPerTrack; sector++)
+      {
+        wdc->readSector(sector, sectorSizeBytes);
+        if (wdc->getLastError())
+        {
+          // WDC timeout, drive not ready, writefault
+          if (wdc->getLastError() < 4)
+          {
+            ui->print(Progmem::getString(Progmem::uiNewLine2x));
+            ui->print(Progmem::getString(wdc->getLastErrorMessage()));
+            ui->print(Progmem::getString(Progmem::uiNewLine));
+            return 0;
+          }
+          
+          errors++;
+          continue;
+        }
+        
+        // consume
+        wdc->sramBeginBufferAccess(false, 0);
+        for (WORD offset = 0; offset < sectorSizeBytes; offset += POOL_SCRATCH_SIZE)
+        {
+          const WORD count = sectorSizeBytes - offset;
+          wdc->sramReadBlock(PoolGetScratch(), (count < POOL_SCRATCH_SIZE) ? count : POOL_SCRATCH_SIZE);
+        }
+        wdc->sramFinishBufferAccess();
+        
+        if (serialMicros)
+        {
+          DWORD now = micros();
+          while ((long)(lineFreeAt - now) > (long)maxBacklog) // ring full
+          {
+            now = micros();
+          }
+          lineFreeAt = (((long)(lineFreeAt - now) > 0) ? lineFreeAt : now) + serialMicros; // line idle: starts sending now
+        }
+      }
+    }
+    
+    // until the ring drained
+    while (serialMicros && ((long)(lineFreeAt - micros()) > 0)) {}
+    
+    // bytes per second, from milliseconds
+    DWORD ms = (micros() - timeStart) / 1000;
+    if (!ms)
+    {
+      ms = 1;
+    }
+    const DWORD rate = (totalBytes * 1000) / ms;
+    const DWORD kbs100 = (rate * 100) / 1024;
+    
+    ui->print(Progmem::getString(Progmem::formatBenchResult), interleave, kbs100 / 100, kbs100 % 100);
+    if (errors)
+    {
+      ui->print(Progmem::getString(Progmem::formatBenchErrors), errors);
+    }
+    ui->print(Progmem::getString(Progmem::uiNewLine));
+    
+    // lowest interleave wins a tie
+    if (!errors && (rate > bestRate))
+    {
+      bestRate = rate;
+      bestInterleave = interleave;
+    }
+  }
+  
+  return bestInterleave;
+}
+
+// skew for sequential reads across tracks: how many sectors pass by during a head switch, or a step to the next cylinder
+// plus one for the firmware to issue the next read; from the revolution on the track (or nominal 3600 RPM, if not formatted yet)
+// the head switch is timed until an ID can be read from head 1, so only on a formatted track; the least of a few tries,
+// each switching a fraction of a sector later after an ID on head 0, so that the wait for the next ID is about nil in one of them
+#define SKEW_TRIES  8
+
+void MeasureSkew(WORD cylinder, BYTE sectorsPerTrack, BYTE& headSkew, BYTE& cylinderSkew)
+{
+  wdc->seekDrive(cylinder, 0);
+  const DWORD period = wdc->measureRotation() ? wdc->getRotation().Period : 16667;
+  const DWORD sectorPeriod = period / sectorsPerTrack;
+  
+  // head switch, until the drive can be read from
+  DWORD headSwitch = 0xFFFFFFFF;
+  for (BYTE attempt = 0; (attempt < SKEW_TRIES) && (wdc->getParams()->Heads > 1); attempt++)
+  {
+    WORD idCylinder;
+    BYTE idSector;
+    BYTE idSdh;
+    wdc->seekDrive(cylinder, 0);
+    wdc->scanID(idCylinder, idSector, idSdh);
+    if (wdc->getLastError())
+    {
+      break;
+    }
+    
+    const DWORD delayStart = micros();
+    while (micros() - delayStart < (sectorPeriod * attempt) / SKEW_TRIES) {}
+    
+    const DWORD timeStart = micros();
+    wdc->seekDrive(cylinder, 1);
+    wdc->scanID(idCylinder, idSector, idSdh);
+    if (wdc->getLastError())
+    {
+      break;
+    }
+    
+    const DWORD elapsed = micros() - timeStart;
+    if (elapsed < headSwitch)
+    {
+      headSwitch = elapsed;
+    }
+  }
+  if (headSwitch == 0xFFFFFFFF) // single head or unformatted, just the firmware
+  {
+    headSwitch = 0;
+  }
+  wdc->seekDrive(cylinder, 0);
+  
+  // one cylinder step there and back, settled; the longer one
+  DWORD trackToTrack = 0;
+  if (wdc->getParams()->Cylinders > 1)
+  {
+    const WORD other = (cylinder+1 < wdc->getParams()->Cylinders) ? cylinder+1 : cylinder-1;
+    wdc->seekDrive(other, 0);
+    trackToTrack = wdc->getLastSeekTime();
+    wdc->seekDrive(cylinder, 0);
+    if (wdc->getLastSeekTime() > trackToTrack)
+    {
+      trackToTrack = wdc->getLastSeekTime();
+    }
+  }
+  
+  const DWORD head = ((headSwitch + sectorPeriod - 1) / sectorPeriod) + 1;
+  const DWORD cyl = trackToTrack ? ((trackToTrack + sectorPeriod - 1) / sectorPeriod) + 1 : 0;
+  headSkew = (head < sectorsPerTrack) ? head : sectorsPerTrack-1;
+  cylinderSkew = (cyl < sectorsPerTrack) ? cyl : sectorsPerTrack-1;
+}
+
 void CommandFormat()
 {
   ui->print(Progmem::getString(Progmem::formatWarning));
@@ -1062,8 +1221,10 @@ void CommandFormat()
   }
   ui->print(Progmem::getString(Progmem::uiEchoKey), key);
   
-  // format interleave
+  // format interleave, or the benchmark to find it (run after the remaining questions, as it reformats a track)
   BYTE interleave = 1;
+  BYTE benchMaxInterleave = 0;
+  bool benchToSerial = false;
   while(true)
   {
     ui->print(Progmem::getString(Progmem::formatInterleave));
@@ -1080,28 +1241,130 @@ void CommandFormat()
       break;
     }
     
+    // benchmark on the first track to be formatted
+    if (strlen(prompt) && (sectorsPerTrack > 2))
+    {
+      ui->print(Progmem::getString(Progmem::uiNewLine));
+      ui->print(Progmem::getString(Progmem::formatBenchAsk), startCylinder);
+      
+      const BYTE limit = (sectorsPerTrack-1 < 16) ? sectorsPerTrack-1 : 16;
+      BYTE maxInterleave = 0;
+      while(true)
+      {
+        ui->print(Progmem::getString(Progmem::formatBenchMax), limit);
+        const BYTE* prompt = ui->prompt(2, Progmem::getString(Progmem::uiDecimalInputEsc), true);
+        if (!prompt)
+        {
+          ui->print(Progmem::getString(Progmem::uiNewLine));
+          return;
+        }
+        maxInterleave = (BYTE)atoi(prompt);
+        if ((maxInterleave >= 2) && (maxInterleave <= limit))
+        {
+          ui->print(Progmem::getString(Progmem::uiNewLine));
+          break;
+        }
+        
+        ui->print(Progmem::getString(Progmem::uiDeleteLine));
+      }
+      
+      ui->print(Progmem::getString(Progmem::formatBenchPath), ui->getBaudRate(PORT_DATA));
+      key = toupper(ui->readKey("SM\e"));
+      if (key == '\e')
+      {
+        ui->print(Progmem::getString(Progmem::uiNewLine));
+        return;
+      }
+      ui->print(Progmem::getString(Progmem::uiEchoKey), key);
+      
+      benchMaxInterleave = maxInterleave;
+      benchToSerial = (key == 'S');
+      break;
+    }
+    
     ui->print(Progmem::getString(Progmem::uiDeleteLine));
   }
   
-  // starting sector
-  WORD startSector = 0;
-  while(true)
+  // track and head skew
+  BYTE headSkew = 0;
+  BYTE cylinderSkew = 0;
+  if (sectorsPerTrack > 1)
   {
-    ui->print(Progmem::getString(Progmem::formatStartSector), 256-sectorsPerTrack);
-    const BYTE* prompt = ui->prompt(3, Progmem::getString(Progmem::uiDecimalInputEsc), true);
-    if (!prompt)
+    ui->print(Progmem::getString(Progmem::formatSkew));
+    key = toupper(ui->readKey("NME\e"));
+    if (key == '\e')
     {
       ui->print(Progmem::getString(Progmem::uiNewLine));
       return;
     }
+    ui->print(Progmem::getString(Progmem::uiEchoKey), key);
     
-    if (strlen(prompt))
+    if (key == 'M')
     {
-      startSector = (WORD)atoi(prompt);
-      if (startSector <= 256-sectorsPerTrack)
+      MeasureSkew(startCylinder, sectorsPerTrack, headSkew, cylinderSkew);
+      ui->print(Progmem::getString(Progmem::formatSkewResult), headSkew, cylinderSkew);
+    }
+    else if (key == 'E')
+    {
+      while(true)
       {
-        ui->print(Progmem::getString(Progmem::uiNewLine));
-        break;
+        ui->print(Progmem::getString(Progmem::formatSkewHead), sectorsPerTrack-1);
+        const BYTE* prompt = ui->prompt(2, Progmem::getString(Progmem::uiDecimalInputEsc), true);
+        if (!prompt)
+        {
+          ui->print(Progmem::getString(Progmem::uiNewLine));
+          return;
+        }
+        headSkew = (BYTE)atoi(prompt);
+        if (strlen(prompt) && (headSkew < sectorsPerTrack))
+        {
+          ui->print(Progmem::getString(Progmem::uiNewLine));
+          break;
+        }
+        
+        ui->print(Progmem::getString(Progmem::uiDeleteLine));
+      }
+      
+      while(true)
+      {
+        ui->print(Progmem::getString(Progmem::formatSkewCyl), sectorsPerTrack-1);
+        const BYTE* prompt = ui->prompt(2, Progmem::getString(Progmem::uiDecimalInputEsc), true);
+        if (!prompt)
+        {
+          ui->print(Progmem::getString(Progmem::uiNewLine));
+          return;
+        }
+        cylinderSkew = (BYTE)atoi(prompt);
+        if (strlen(prompt) && (cylinderSkew < sectorsPerTrack))
+        {
+          ui->print(Progmem::getString(Progmem::uiNewLine));
+          break;
+        }
+        
+        ui->print(Progmem::getString(Progmem::uiDeleteLine));
+      }
+    }
+  }
+  
+  // starting sector
+  WORD startSector = 0;
+  while(true)
+  {
+    ui->print(Progmem::getString(Progmem::formatStartSector), 256-sectorsPerTrack);
+    const BYTE* prompt = ui->prompt(3, Progmem::getString(Progmem::uiDecimalInputEsc), true);
+    if (!prompt)
+    {
+      ui->print(Progmem::getString(Progmem::uiNewLine));
+      return;
+    }
+    
+    if (strlen(prompt))
+    {
+      startSector = (WORD)atoi(prompt);
+      if (startSector <= 256-sectorsPerTrack)
+      {
+        ui->print(Progmem::getString(Progmem::uiNewLine));
+        break;
       }
     }    
    
@@ -1134,19 +1397,33 @@ void CommandFormat()
     ui->print(Progmem::getString(Progmem::uiEchoKey), key);  
   }
   
-  BYTE badBlocksCount = 0;
+  const BYTE heads = wdc->getParams()->Heads;
+  
+  // all answered: interleave benchmark on the first track to be formatted
+  if (benchMaxInterleave)
+  {
+    ui->print(Progmem::getString(Progmem::uiNewLine));
+    interleave = BenchmarkInterleave(startCylinder, sectorsPerTrack, sectorSizeBytes, benchMaxInterleave, benchToSerial);
+    if (!interleave)
+    {
+      return;
+    }
+    ui->print(Progmem::getString(Progmem::formatBenchBest), interleave);
+  }
   
   // format
   ui->print(Progmem::getString(Progmem::uiNewLine));  
   for (WORD cylinder = startCylinder; cylinder <= endCylinder; cylinder++)
   {
-    // for all heads
-    BYTE head = 0;
-    while (head < wdc->getParams()->Heads)
+    // skew accumulates in the order tracks are read: all heads of a cylinder, then the next cylinder
+    const DWORD skewBase = (DWORD)cylinder * ((heads-1) * headSkew + cylinderSkew);
+    
+    // all heads of the cylinder first
+    for (BYTE head = 0; head < heads; head++)
     {   
       ui->print(Progmem::getString(Progmem::formatProgress), cylinder, head);
       
-      wdc->prepareFormatInterleave(sectorsPerTrack, interleave, startSector);
+      wdc->prepareFormatInterleave(sectorsPerTrack, interleave, startSector, NULL, (skewBase + head * headSkew) % sectorsPerTrack);
       wdc->seekDrive(cylinder, head);      
       wdc->formatTrack(sectorsPerTrack, sectorSizeBytes);
       
@@ -1158,16 +1435,53 @@ void CommandFormat()
         ui->print(Progmem::getString(Progmem::uiNewLine));
         return;
       }
+    }
+    
+    if (!withVerify)
+    {
+      continue;
+    }
+    
+    // then verify them all, without moving the heads
+    for (BYTE head = 0; head < heads; head++)
+    {
+      wdc->seekDrive(cylinder, head);
+      wdc->verifyTrack(sectorsPerTrack, sectorSizeBytes, startSector);
+      if (!wdc->getLastError())
+      {
+        continue;
+      }
       
-      // with verify?
-      if (withVerify)
+      // WDC timeout, drive not ready, writefault - abort the command
+      if (wdc->getLastError() < 4)
+      {  
+        ui->print(Progmem::getString(Progmem::uiNewLine2x));
+        ui->print(Progmem::getString(wdc->getLastErrorMessage()));
+        ui->print(Progmem::getString(Progmem::uiNewLine));
+        return;        
+      }
+      
+      // adjust which range sectors to check, depending on the starting sector
+      WORD endSector = sectorsPerTrack;
+      if (startSector == 0)
       {
-        badBlocksCount = 0;
-
-        wdc->verifyTrack(sectorsPerTrack, sectorSizeBytes, startSector);
+        endSector--;
+      }
+      else if (startSector > 1)
+      {
+        endSector += startSector-1;
+      }
+      
+      // fall back to single sector reads to determine which failed
+      // bad ones are collected by their position in the logical sequence, up to 63 sectors per track
+      DWORD badSectors[2] = {0, 0};
+      BYTE badBlocksCount = 0;
+      for (WORD sector = startSector; sector <= endSector; sector++)
+      {
+        wdc->readSector(sector, sectorSizeBytes); 
+        
         if (wdc->getLastError())
         {
-          // WDC timeout, drive not ready, writefault - abort the command
           if (wdc->getLastError() < 4)
           {  
             ui->print(Progmem::getString(Progmem::uiNewLine2x));
@@ -1176,54 +1490,50 @@ void CommandFormat()
             return;        
           }
           
-          // adjust which range sectors to check, depending on the starting sector
-          WORD endSector = sectorsPerTrack;
-          if (startSector == 0)
-          {
-            endSector--;
-          }
-          else if (startSector > 1)
-          {
-            endSector += startSector-1;
-          }
+          // prepend CHS information
+          ui->print(Progmem::getString(Progmem::uiCHSInfo), cylinder, head, sector);
+          ui->print(Progmem::getString(wdc->getLastErrorMessage()));
           
-          // fall back to single sector reads to determine which failed
-          for (WORD sector = startSector; sector <= endSector; sector++)
-          {
-            wdc->readSector(sector, sectorSizeBytes); 
-            
-            if (wdc->getLastError())
-            {
-              if (wdc->getLastError() < 4)
-              {  
-                ui->print(Progmem::getString(Progmem::uiNewLine2x));
-                ui->print(Progmem::getString(wdc->getLastErrorMessage()));
-                ui->print(Progmem::getString(Progmem::uiNewLine));
-                return;        
-              }
-              
-              // prepend CHS information
-              ui->print(Progmem::getString(Progmem::uiCHSInfo), cylinder, head, sector);
-              ui->print(Progmem::getString(wdc->getLastErrorMessage()));
-              
-              // mark sector as bad
-              if (formatBadBlocks)
-              {
-                wdc->setBadSector(sector);
-              }
-              badBlocksCount++;
-            }
-          }
+          const BYTE index = (BYTE)(sector - startSector);
+          badSectors[index / 32] |= 1UL << (index % 32);
+          badBlocksCount++;
         }
+      }
+      
+      if (!badBlocksCount)
+      {
+        continue;
+      }
+      ui->print(Progmem::getString(Progmem::uiNewLine));
+      
+      // mark them all as bad in a single re-format of the track, instead of a setBadSector() each
+      if (formatBadBlocks)
+      {
+        const BYTE skew = (skewBase + head * headSkew) % sectorsPerTrack;
+        
+        // the interleave table tells which physical sector got which number
+        BYTE badBlocksTable[63];
+        wdc->prepareFormatInterleave(sectorsPerTrack, interleave, startSector, NULL, skew);
+        wdc->sramBeginBufferAccess(false, 0);
+        for (BYTE physical = 0; physical < sectorsPerTrack; physical++)
+        {
+          wdc->sramReadByteSequential(); // bad block mark, none yet
+          const BYTE index = (BYTE)(wdc->sramReadByteSequential() - startSector);
+          badBlocksTable[physical] = (BYTE)((badSectors[index / 32] >> (index % 32)) & 1);
+        }
+        wdc->sramFinishBufferAccess();
         
-        if (badBlocksCount)
+        wdc->prepareFormatInterleave(sectorsPerTrack, interleave, startSector, badBlocksTable, skew);
+        wdc->formatTrack(sectorsPerTrack, sectorSizeBytes);
+        if (wdc->getLastError())
         {
+          ui->print(Progmem::getString(Progmem::uiNewLine2x));
+          ui->print(Progmem::getString(wdc->getLastErrorMessage()));
           ui->print(Progmem::getString(Progmem::uiNewLine));
+          return;
         }
       }
-
-      head++;
-    }    
+    }
   }
    
   ui->print(Progmem::getString(Progmem::formatComplete));  
@@ -1305,149 +1615,119 @@ void CommandScan()
   DWORD dataErrors = 0;
   ui->print(Progmem::getString(Progmem::uiNewLine));
    
-  for (WORD cylinder = startCylinder; cylinder <= endCylinder; cylinder++)
-  {
-    ui->print(Progmem::getString(Progmem::scanProgress), cylinder);
+  // all tracks of the range, in the traversal order
+  Traversal traversal;
+  TraversalBegin(traversal, startCylinder, endCylinder);
+  do
+  {
+    const WORD cylinder = traversal.Cylinder;
+    const BYTE head = traversal.Head;
+    if (head == traversal.FirstHead)
+    {
+      ui->print(Progmem::getString(Progmem::scanProgress), cylinder);
+    }
     
-    BYTE head = 0;
-    while (head < wdc->getParams()->Heads)
-    {   
-      wdc->seekDrive(cylinder, head);
-
-      BYTE sdh;
-      BYTE attempts = 5;      
-      while (attempts)
-      {
-        WORD dummy;
-        BYTE dummy2;        
-        wdc->scanID(dummy, dummy2, sdh);
-        
-        if (wdc->getLastError())
-        {
-          if (wdc->getLastError() < 4)
-          {
-            ui->print(Progmem::getString(Progmem::uiNewLine));
-            ui->print(Progmem::getString(wdc->getLastErrorMessage()));
-            ui->print(Progmem::getString(Progmem::uiNewLine));
-            return;        
-          }
+    wdc->seekDrive(cylinder, head);
+    
+    BYTE sdh;
+    WORD tableCount = 0;
+    WD42C22::TrackGeometry geometry;
+    DWORD* sectorsTable = ScanTrack(sdh, tableCount, geometry);
+    const BYTE sectorsPerTrack = geometry.SectorsPerTrack;
+    
+    if (!sectorsTable && wdc->getLastError() && (wdc->getLastError() < 4))
+    {
+      ui->print(Progmem::getString(Progmem::uiNewLine));
+      ui->print(Progmem::getString(wdc->getLastErrorMessage()));
+      ui->print(Progmem::getString(Progmem::uiNewLine));
+      return;        
+    }
+    
+    if (!sectorsPerTrack)
+    {
+      unreadableTracks++;
+      continue;
+    }
+    
+    WORD trySectorSize = wdc->getSectorSizeFromSDH(sdh);
           
-          attempts--;
-        }
-        else
-        {
-          break;
-        }
-      }
-      
-      if (!attempts)
+    // try whole track with uniform sector size
+    BYTE startingSector = (BYTE)-1;
+    for (WORD idx = 0; idx < tableCount; idx++)
+    {
+      const DWORD& sectorData = sectorsTable[idx];
+      if (sectorData == 0xFFFFFFFFUL) // undefined
       {
-        unreadableTracks++;
-        head++;
         continue;
-      }   
+      }
       
-      bool dummy;      
-      WORD tableCount = 0;
-      BYTE sectorsPerTrack = 0;
-      DWORD* sectorsTable = CalculateSectorsPerTrack(sdh, sectorsPerTrack, tableCount,
-                                                     dummy, dummy, dummy);
-      if (!sectorsPerTrack)
+      const BYTE sector = (BYTE)(sectorData >> 16);
+      if (sector < startingSector)
       {
-        unreadableTracks++;
-        if (sectorsTable)
-        {
-          delete[] sectorsTable;
-        }
-        
-        head++;
-        continue;
+        startingSector = sector;
       }
-      
-      WORD trySectorSize = wdc->getSectorSizeFromSDH(sdh);
-            
-      // try whole track with uniform sector size
-      BYTE startingSector = (BYTE)-1;
-      for (WORD idx = 0; idx < tableCount; idx++)
+    }
+    wdc->verifyTrack(sectorsPerTrack, trySectorSize, startingSector);
+    
+    if (wdc->getLastError())
+    {
+      if (wdc->getLastError() < 4)
+      {  
+        ui->print(Progmem::getString(Progmem::uiNewLine2x));
+        ui->print(Progmem::getString(wdc->getLastErrorMessage()));
+        ui->print(Progmem::getString(Progmem::uiNewLine));
+        return;        
+      }
+              
+      for (BYTE sector = 0; sector < sectorsPerTrack; sector++)
       {
-        const DWORD& sectorData = sectorsTable[idx];
-        if (sectorData == 0xFFFFFFFFUL) // undefined
+        if (sectorsTable[sector] == 0xFFFFFFFFUL)
         {
           continue;
         }
         
-        const BYTE sector = (BYTE)(sectorData >> 16);
-        if (sector < startingSector)
-        {
-          startingSector = sector;
-        }
-      }
-      wdc->verifyTrack(sectorsPerTrack, trySectorSize, startingSector);
+        const BYTE sdh2 = (BYTE)(sectorsTable[sector] >> 24);
+        trySectorSize = wdc->getSectorSizeFromSDH(sdh2);        
+        
+        const BYTE logicalSector = (BYTE)(sectorsTable[sector] >> 16);
+        const WORD logicalCylinder = (WORD)sectorsTable[sector];
+        const BYTE logicalHead = sdh2 & 0xF;        
       
-      if (wdc->getLastError())
-      {
-        if (wdc->getLastError() < 4)
-        {  
-          ui->print(Progmem::getString(Progmem::uiNewLine2x));
-          ui->print(Progmem::getString(wdc->getLastErrorMessage()));
-          ui->print(Progmem::getString(Progmem::uiNewLine));
-          delete[] sectorsTable;
-          return;        
+        // single sector with variable sector size
+        wdc->readSector(logicalSector, trySectorSize, false, &logicalCylinder, &logicalHead);
+        BYTE error = wdc->getLastError();
+        if ((error == WDC_CORRECTED) && !marginalSectorsAsBad)
+        {
+          error = WDC_OK; // cancel off error flag
         }
-                
-        for (BYTE sector = 0; sector < sectorsPerTrack; sector++)
+        
+        if (error)
         {
-          if (sectorsTable[sector] == 0xFFFFFFFFUL)
-          {
-            continue;
+          if (error < 4)
+          {  
+            ui->print(Progmem::getString(Progmem::uiNewLine2x));
+            ui->print(Progmem::getString(wdc->getLastErrorMessage()));
+            ui->print(Progmem::getString(Progmem::uiNewLine));
+            return;        
           }
           
-          const BYTE sdh2 = (BYTE)(sectorsTable[sector] >> 24);
-          trySectorSize = wdc->getSectorSizeFromSDH(sdh2);        
-          
-          const BYTE logicalSector = (BYTE)(sectorsTable[sector] >> 16);
-          const WORD logicalCylinder = (WORD)sectorsTable[sector];
-          const BYTE logicalHead = sdh2 & 0xF;        
-        
-          // single sector with variable sector size
-          wdc->readSector(logicalSector, trySectorSize, false, &logicalCylinder, &logicalHead);
-          BYTE error = wdc->getLastError();
-          if ((error == WDC_CORRECTED) && !marginalSectorsAsBad)
+          if ((error == WDC_DATAERROR) || (error == WDC_CORRECTED))
           {
-            error = WDC_OK; // cancel off error flag
+            dataErrors++;
+            
+            // write ID as bad sector
+            wdc->setBadSector(logicalSector, &logicalCylinder, &logicalHead);
           }
           
-          if (error)
+          else
           {
-            if (error < 4)
-            {  
-              ui->print(Progmem::getString(Progmem::uiNewLine2x));
-              ui->print(Progmem::getString(wdc->getLastErrorMessage()));
-              ui->print(Progmem::getString(Progmem::uiNewLine));
-              delete[] sectorsTable;
-              return;        
-            }
-            
-            if ((error == WDC_DATAERROR) || (error == WDC_CORRECTED))
-            {
-              dataErrors++;
-              
-              // write ID as bad sector
-              wdc->setBadSector(logicalSector, &logicalCylinder, &logicalHead);
-            }
-            
-            else
-            {
-              existingBadBlocks++;
-            }
+            existingBadBlocks++;
           }
         }
-      }        
-        
-      delete[] sectorsTable;     
-      head++;
-    }    
+      }
+    }        
   }
+  while (TraversalNext(traversal));
 
   ui->print(Progmem::getString(Progmem::uiNewLine2x));
   
@@ -1515,6 +1795,94 @@ void CommandShowParams()
   
   ui->print(Progmem::getString(Progmem::uiShowSeekMode));
   ui->print(Progmem::getString(wdc->getParams()->SlowSeek ? Progmem::uiShowSeekSlow : Progmem::uiShowSeekFast));
+  
+  ui->print(Progmem::getString(Progmem::uiShowSeekProfile));
+  switch(wdc->getParams()->SeekProfile)
+  {
+  case SEEK_PROFILE_RAMPED:
+    ui->print(Progmem::getString(Progmem::uiShowProfileRamped));
+    break;
+  case SEEK_PROFILE_BURST:
+    ui->print(Progmem::getString(Progmem::uiShowProfileBurst));
+    break;
+  default:
+    ui->print(Progmem::getString(Progmem::uiShowProfileConstant));
+    break;
+  }
+  
+  PoolShowReport();
+}
+
+// seek test timings, in microseconds
+#define SEEKTEST_BUCKETS  13   // histogram: < 1, 2, 4 ... 2048ms, and above
+#define SEEKTEST_STROKES  8    // back and forth repetitions for each of the track-to-track, one-third and full stroke times
+
+struct SeekTimes
+{
+  WORD Count;
+  DWORD Sum;
+  DWORD Min;
+  DWORD Max;
+};
+
+// seek and account for the time it took: histogram, optional CSV line and stroke times if given
+void SeekTestSeek(WORD cylinder, DWORD* histogram, bool csvExport, SeekTimes* times = NULL)
+{
+  wdc->seekDrive(cylinder, 0);
+  
+  const WORD distance = wdc->getLastSeekDistance();
+  const DWORD time = wdc->getLastSeekTime();
+  if (!distance)
+  {
+    return;
+  }
+  
+  // log2 bucket of milliseconds
+  BYTE bucket = 0;
+  DWORD ms = time / 1000;
+  while (ms && (bucket < SEEKTEST_BUCKETS-1))
+  {
+    ms >>= 1;
+    bucket++;
+  }
+  histogram[bucket]++;
+  
+  if (csvExport)
+  {
+    ui->print(Progmem::getString(Progmem::seektestExportLine), distance, time);
+  }
+  
+  if (times)
+  {
+    times->Count++;
+    times->Sum += time;
+    if (time < times->Min) times->Min = time;
+    if (time > times->Max) times->Max = time;
+  }
+}
+
+// seeks between two cylinders, then prints avg/min/max
+void SeekTestStroke(BYTE label, WORD from, WORD to, DWORD* histogram, bool csvExport)
+{
+  SeekTimes times = {0, 0, 0xFFFFFFFF, 0};
+  SeekTestSeek(from, histogram, csvExport);
+  for (BYTE count = 0; count < SEEKTEST_STROKES; count++)
+  {
+    SeekTestSeek(to, histogram, csvExport, &times);
+    SeekTestSeek(from, histogram, csvExport, &times);
+  }
+  
+  if (!times.Count)
+  {
+    return;
+  }
+  
+  // hundredths of ms
+  const DWORD avg = (times.Sum / times.Count) / 10;
+  const DWORD min = times.Min / 10;
+  const DWORD max = times.Max / 10;
+  ui->print(Progmem::getString(label));
+  ui->print(Progmem::getString(Progmem::seektestStrokeTime), avg / 100, avg % 100, min / 100, min % 100, max / 100, max % 100);
 }
 
 void CommandSeekTest()
@@ -1627,8 +1995,19 @@ void CommandSeekTest()
     return;
   }
   
+  // each seek as distance,microseconds for further processing on the terminal side
+  ui->print(Progmem::getString(Progmem::seektestAskExport));
+  const BYTE key = toupper(ui->readKey("YN"));
+  ui->print(Progmem::getString(Progmem::uiEchoKey), key);
+  const bool csvExport = (key == 'Y');
+  
+  DWORD histogram[SEEKTEST_BUCKETS] = {0};
   WORD count;
   ui->print(Progmem::getString(Progmem::seektestProgress), startCylinder, endCylinder);
+  if (csvExport)
+  {
+    ui->print(Progmem::getString(Progmem::seektestExportHeader));
+  }
   
   // back and forth tests (seekDrive on error halts execution)
   if (backForthTests)
@@ -1638,8 +2017,8 @@ void CommandSeekTest()
     
     for (count = 0; count < backForthTests; count++)
     {
-      wdc->seekDrive(endCylinder, 0);
-      wdc->seekDrive(startCylinder, 0);
+      SeekTestSeek(endCylinder, histogram, csvExport);
+      SeekTestSeek(startCylinder, histogram, csvExport);
     }
     
     ui->print(Progmem::getString(Progmem::uiNewLine));
@@ -1659,8 +2038,8 @@ void CommandSeekTest()
       
       while (count2--)
       {
-        wdc->seekDrive(start++, 0);
-        wdc->seekDrive(end--, 0);        
+        SeekTestSeek(start++, histogram, csvExport);
+        SeekTestSeek(end--, histogram, csvExport);
       }
     }
     
@@ -1675,11 +2054,41 @@ void CommandSeekTest()
     
     for (count = 0; count < randomTests; count++)
     {
-      wdc->seekDrive(random(startCylinder, endCylinder+1), 0);
+      SeekTestSeek(random(startCylinder, endCylinder+1), histogram, csvExport);
     }
     
     ui->print(Progmem::getString(Progmem::uiNewLine));
-  }  
+  }
+  
+  // typical access times within the tested range
+  ui->print(Progmem::getString(Progmem::seektestTimes));
+  SeekTestStroke(Progmem::seektestTrackToTrack, startCylinder, startCylinder+1, histogram, csvExport);
+  SeekTestStroke(Progmem::seektestThirdStroke, startCylinder, startCylinder + (endCylinder-startCylinder) / 3, histogram, csvExport);
+  SeekTestStroke(Progmem::seektestFullStroke, startCylinder, endCylinder, histogram, csvExport);
+  
+  DWORD total = 0;
+  for (BYTE bucket = 0; bucket < SEEKTEST_BUCKETS; bucket++)
+  {
+    total += histogram[bucket];
+  }
+  
+  ui->print(Progmem::getString(Progmem::seektestHistogram), total);
+  for (BYTE bucket = 0; bucket < SEEKTEST_BUCKETS; bucket++)
+  {
+    if (!histogram[bucket])
+    {
+      continue;
+    }
+    
+    if (bucket < SEEKTEST_BUCKETS-1)
+    {
+      ui->print(Progmem::getString(Progmem::seektestBucket), 1UL << bucket, histogram[bucket]);
+    }
+    else
+    {
+      ui->print(Progmem::getString(Progmem::seektestBucketOver), 1UL << (bucket-1), histogram[bucket]);
+    }
+  }
 }
 
 void CommandPark()
@@ -1699,237 +2108,301 @@ void CommandPark()
   ui->print(Progmem::getString(Progmem::parkContinue));
   ui->readKey(NULL);
 
-  // use the slow recalibrate command to seek back to 0, as the landing zone might be sometimes outside the cylinders count
+  // recalibrate to seek back to 0; the slow way, if the landing zone is outside the cylinders count (drive might recalibrate by itself)
   ui->print(Progmem::getString(Progmem::parkRecalibrating));
-  wdc->recalibrate();
+  wdc->recalibrate(wdc->getParams()->LandingZone < wdc->getParams()->Cylinders);
   ui->print(Progmem::getString(Progmem::uiDeleteLine));
+  ui->print(Progmem::getString(Progmem::parkRecalibrated), wdc->getRecalibrateTime());
 }
 
-DWORD* CalculateSectorsPerTrack(BYTE sdh, // input
-                                BYTE& sectorsPerTrack, WORD& tableCount, // outputs
-                                bool& headMismatch, bool& cylinderMismatch, bool& variableSectorSize) // ditto
+void CommandRotation()
 {
-  // returns maximum sectors per track observed, and a table of sectors of count tableCount
-  // also sets output warning flags if non standard stuff were found
-  // inside the table, each sector entry takes 4 bytes:
-  // bits 31-24: SDH byte (contains bits: bad block, sector size and logical head number)
-  //      23-16: logical sector number, ordered sequentially or with interleave
-  //      15-8:  logical cylinder number, MSB
-  //       7-0:  logical cylinder number, LSB
-  // "logical" cylinder, head and sector numbers do not always correspond with physical CHS  
+  ui->print(Progmem::getString(Progmem::uiNewLine));
+  ui->print(Progmem::getString(Progmem::uiOperationPending));
   
-  sectorsPerTrack = 0;
-  headMismatch = false;
-  cylinderMismatch = false;  
-  variableSectorSize = false;
+  // on cylinder 0, head 0
+  wdc->seekDrive(0, 0);
+  const bool measured = wdc->measureRotation();
+  ui->print(Progmem::getString(Progmem::uiDeleteLine));
+  if (!measured)
+  {
+    ui->print(Progmem::getString(Progmem::rotationFailed));
+    return;
+  }
   
-  // up to 5 attempts at getting the maximum SPT number
-  DWORD* attempts[5] = {NULL};
-  BYTE idx;
-  BYTE idxToUse = (BYTE)-1; // unsure, yet
+  const WD42C22::RotationInfo& rotation = wdc->getRotation();
+  const DWORD rpm100 = wdc->getRPM100();
+  const DWORD jitter = rotation.PeriodMax - rotation.PeriodMin;
+  const DWORD jitter100 = (jitter * 10000) / rotation.Period; // percent * 100
   
-  for (idx = 0; idx < 5; idx++)
+  ui->print(Progmem::getString(Progmem::rotationRPM), rpm100 / 100, rpm100 % 100);
+  ui->print(Progmem::getString(Progmem::rotationPeriod), rotation.Period, rotation.PeriodMin, rotation.PeriodMax);
+  ui->print(Progmem::getString(Progmem::rotationJitter), jitter, jitter100 / 100, jitter100 % 100);
+  ui->print(Progmem::getString(Progmem::rotationSectors), rotation.SectorsPerTrack, rotation.SectorPeriod);
+  ui->print(Progmem::getString(Progmem::rotationGap), rotation.GapPeriod, rotation.GapSector);
+}
+
+// before a long operation: false if the spindle speed varies too much, and the user chose not to continue
+bool CheckRotationStable(WORD cylinder)
+{
+  wdc->seekDrive(cylinder, 0);
+  if (!wdc->measureRotation())
   {
-    // distinguish if there are missing sector IDs in the table
-    // no gaps: observedSPT == maximumSPT
-    BYTE observedSPT = 0;
-    BYTE maximumSPT = 0;
-    
-    bool compute = false;
-    bool sectorZeroObserved = false;
-    BYTE computeSPT = 0;
-    WORD idxSPTComputer = 0;
-    
-    attempts[idx] = wdc->fillSectorsTable(tableCount);    
-    const DWORD* sectorsTable = attempts[idx];
-    if (!sectorsTable)
+    return true; // nothing to say, the operation will find out
+  }
+  
+  const WD42C22::RotationInfo& rotation = wdc->getRotation();
+  const DWORD jitter100 = ((rotation.PeriodMax - rotation.PeriodMin) * 10000) / rotation.Period;
+  if (jitter100 <= ROTATION_JITTER_WARN)
+  {
+    return true;
+  }
+  
+  const DWORD rpm100 = wdc->getRPM100();
+  ui->print(Progmem::getString(Progmem::rotationUnstable), rpm100 / 100, rpm100 % 100, jitter100 / 100, jitter100 % 100);
+  ui->print(Progmem::getString(Progmem::rotationContinue));
+  const BYTE key = toupper(ui->readKey("YN"));
+  ui->print(Progmem::getString(Progmem::uiEchoKey), key);
+  return key == 'Y';
+}
+
+// the track after the current one, without advancing; false if it was the last one
+static bool TraversalStep(const Traversal& traversal, WORD& cylinder, BYTE& head, bool& headsDown)
+{
+  const BYTE heads = wdc->getParams()->Heads;
+  cylinder = traversal.Cylinder;
+  head = traversal.Head;
+  headsDown = traversal.HeadsDown;
+  
+  // next head on this cylinder
+  if (!headsDown && (head < heads-1))
+  {
+    head++;
+    return true;
+  }
+  if (headsDown && head)
+  {
+    head--;
+    return true;
+  }
+  
+  // next cylinder
+  if (traversal.Downwards)
+  {
+    if (cylinder == traversal.StartCylinder)
     {
-      break; // memory error
+      return false;
     }
-    
-    for (WORD index = 0; index < tableCount; index++)
+    cylinder--;
+  }
+  else
+  {
+    if (cylinder == traversal.EndCylinder)
     {
-      const DWORD& data = sectorsTable[index];
-      if (data == 0xFFFFFFFFUL) // all four bytes undefined: cylinder number lo-hi, sector number, SDH
-      {
-        continue;
-      }
-      
-      const BYTE sectorScanned = (BYTE)(data >> 16);
-      const BYTE sdhScanned = (BYTE)(data >> 24);
-      sectorZeroObserved |= !sectorScanned;
-      
-      if (!cylinderMismatch)      
-      {
-        cylinderMismatch = (WORD)data != wdc->getPhysicalCylinder(); // loword: cylinder number 
-      }      
-      if (!headMismatch) // head number in SDH
-      {       
-#if defined(WDC_FORCE_3BIT_SDH) && (WDC_FORCE_3BIT_SDH == 1)
-        headMismatch = (wdc->getPhysicalHead() & 7) != (sdhScanned & 7);
-#else
-        headMismatch = wdc->getPhysicalHead() != (sdhScanned & 0xF);
-#endif
-      }
-      if (!variableSectorSize)
-      {
-        variableSectorSize = (sdh & 0x9F) != (sdhScanned & 0x9F); // sector size code
-      }
-         
-      // determine sectors per track
-      if (idxSPTComputer == 0)
-      {
-        // count number of times until we see the same sector again: that's the observed SPT
-        computeSPT = sectorScanned;
-        compute = true;
-      }
-      else if (computeSPT == sectorScanned)
-      {
-        compute = false; // stop counting        
-      }
-      if (compute)
-      {
-        observedSPT++;
-      }
-      
-      // the maximum logical sector value seen
-      if (sectorScanned > maximumSPT)
-      {
-        maximumSPT = sectorScanned;
-      }
-      idxSPTComputer++;
+      return false;
     }
-    
-    // account for logical sector number 0
-    if (sectorZeroObserved)
+    cylinder++;
+  }
+  
+#if TRAVERSAL_ORDER != TRAVERSAL_LINEAR
+  // serpentine: stay on the last head, no head switch across the cylinder step
+  headsDown = !headsDown;
+#endif
+  head = headsDown ? heads-1 : 0;
+  return true;
+}
+
+void TraversalBegin(Traversal& traversal, WORD startCylinder, WORD endCylinder)
+{
+  traversal.StartCylinder = startCylinder;
+  traversal.EndCylinder = endCylinder;
+  traversal.Downwards = false;
+  traversal.HeadsDown = false;
+  traversal.Done = false;
+  
+#if TRAVERSAL_ORDER == TRAVERSAL_SWEEP
+  // begin at whichever end of the range is nearer to the heads
+  const WORD current = wdc->getPhysicalCylinder();
+  const WORD toStart = (current > startCylinder) ? current - startCylinder : startCylinder - current;
+  const WORD toEnd = (current > endCylinder) ? current - endCylinder : endCylinder - current;
+  traversal.Downwards = toEnd < toStart;
+#endif
+
+  traversal.Cylinder = traversal.Downwards ? endCylinder : startCylinder;
+  traversal.Head = 0;
+  traversal.FirstHead = 0;
+}
+
+bool TraversalNext(Traversal& traversal)
+{
+  WORD cylinder;
+  BYTE head;
+  bool headsDown;
+  if (traversal.Done || !TraversalStep(traversal, cylinder, head, headsDown))
+  {
+    traversal.Done = true;
+    return false;
+  }
+  
+  if (cylinder != traversal.Cylinder)
+  {
+    traversal.FirstHead = head;
+  }
+  traversal.Cylinder = cylinder;
+  traversal.Head = head;
+  traversal.HeadsDown = headsDown;
+  return true;
+}
+
+bool TraversalPeek(const Traversal& traversal, WORD& cylinder, BYTE& head)
+{
+  bool headsDown;
+  return !traversal.Done && TraversalStep(traversal, cylinder, head, headsDown);
+}
+
+WORD TraversalHome()
+{
+#if TRAVERSAL_ORDER != TRAVERSAL_LINEAR
+  // the landing zone, if within the disk and nearer than cylinder 0
+  const WD42C22::DiskDriveParams* params = wdc->getParams();
+  if (params->UseLandingZone && (params->LandingZone < params->Cylinders))
+  {
+    const WORD current = wdc->getPhysicalCylinder();
+    const WORD toLandingZone = (current > params->LandingZone) ? current - params->LandingZone : params->LandingZone - current;
+    if (toLandingZone < current)
     {
-      maximumSPT++;
+      return params->LandingZone;
     }
+  }
+#endif
+
+  return 0;
+}
+
+DWORD* CalculateSectorsPerTrack(WORD& tableCount, WD42C22::TrackGeometry& geometry) // outputs
+{
+  // returns the geometry of the track under the head, and a table of sectors of count tableCount
+  // the table is in the static pool, valid until the next call (or ScanTrack)
+  // geometry flags are set if non standard stuff were found
+  // inside the table, each sector entry takes 4 bytes:
+  // bits 31-24: SDH byte (contains bits: bad block, sector size and logical head number)
+  //      23-16: logical sector number, ordered sequentially or with interleave
+  //      15-8:  logical cylinder number, MSB
+  //       7-0:  logical cylinder number, LSB
+  // "logical" cylinder, head and sector numbers do not always correspond with physical CHS  
+  
+  tableCount = 0;
+  memset(&geometry, 0, sizeof(WD42C22::TrackGeometry));
+  
+  // one revolution is normally enough; up to 5 attempts if sector IDs were missed (gaps),
+  // only the best table so far is kept, the next attempt goes to the other pool table
+  DWORD* result = NULL;
+  BYTE tableToFill = 0;
+  
+  for (BYTE idx = 0; idx < 5; idx++)
+  {
+    WORD count;
+    DWORD* sectorsTable = wdc->fillSectorsTable(count, PoolGetTable(tableToFill));
+    const WD42C22::TrackGeometry& observed = wdc->getTrackGeometry();
     
-    // failsafe    
-    if (observedSPT > maximumSPT)
+    if (observed.SectorsPerTrack > geometry.SectorsPerTrack)
     {
-      observedSPT = maximumSPT;
+      geometry = observed;
+      tableCount = count;
+      result = sectorsTable;
+      tableToFill ^= 1; // keep this one
     }
     
     // no gaps in the sectors being scanned, done
-    if ((observedSPT == maximumSPT) && (observedSPT > 0))
+    if (result && !(geometry.Flags & TRACK_ID_GAPS))
     {
-      sectorsPerTrack = observedSPT;
-      idxToUse = idx;
       break;
     }
-    
-    // gaps present, retry
-    if (observedSPT > sectorsPerTrack)
+  }
+  
+  return result;  
+}
+
+DWORD* ScanTrack(BYTE& sdh, WORD& tableCount, WD42C22::TrackGeometry& geometry) // outputs
+{
+  // sector IDs of the track under the head: from the track cache if it was seen before,
+  // otherwise scanID (up to 5 attempts) and CalculateSectorsPerTrack, then cache it if uniform
+  // the table is in the static pool, valid until the next call
+  // returns NULL and SectorsPerTrack 0 if no valid sector ID was found,
+  // check getLastError() < 4 for WDC timeout, drive not ready or writefault
+  
+  sdh = 0;
+  tableCount = 0;
+  memset(&geometry, 0, sizeof(WD42C22::TrackGeometry));
+  
+  const WD42C22::TrackInfo* cached = wdc->getCachedTrack();
+  if (cached)
+  {
+    // rebuild the table for 2 revolutions, as the users of it look past the lowest sector number    
+    tableCount = cached->Geometry.SectorsPerTrack * 2; // TRACK_CACHE_MAX_SPT*2 fits in POOL_TABLE_ENTRIES
+    DWORD* table = PoolGetTable(0);
+    for (WORD idx = 0; idx < tableCount; idx++)
     {
-      sectorsPerTrack = observedSPT;
-      idxToUse = idx;
-    }      
+      table[idx] = ((DWORD)cached->SDH << 24) | ((DWORD)cached->Sectors[idx % cached->Geometry.SectorsPerTrack] << 16) | cached->LogicalCylinder;
+    }
+    
+    sdh = cached->SDH;
+    geometry = cached->Geometry;
+    return table;
   }
   
-  // now determine which index to use, if ever
-  DWORD* result = NULL;
-  for (idx = 0; idx < 5; idx++)
+  BYTE attempts = 5;      
+  while (attempts)
   {
-    if (attempts[idx])
+    WORD dummy;
+    BYTE dummy2;        
+    wdc->scanID(dummy, dummy2, sdh);
+    
+    if (wdc->getLastError())
     {
-      if (idx == idxToUse)
+      if (wdc->getLastError() < 4)
       {
-        result = attempts[idx];
-        continue;
+        return NULL;
       }
       
-      delete[] attempts[idx]; // and deallocate the rest
+      attempts--;
+    }
+    else
+    {
+      break;
     }
   }
   
-  return result;  
-}
-
-bool CalculateInterleave(const DWORD* sectorsTable, WORD tableCount, BYTE sectorsPerTrack, BYTE& result)
-{
-  // sequential
-  if (sectorsPerTrack < 3)
+  // no single valid sector ID found
+  if (!attempts)
   {
-    result = 1;
-    return true;
+    return NULL;
   }
   
-  BYTE startSector = (BYTE)-1;
-  WORD idx = 0;
-  WORD idx2 = 0;
-  
-  // find the lowest logical sector number and its index in the sectors table  
-  while (idx < tableCount)
+  DWORD* table = CalculateSectorsPerTrack(tableCount, geometry);
+  const BYTE sectorsPerTrack = geometry.SectorsPerTrack;
+  if (!table || !sectorsPerTrack || (geometry.Flags & (TRACK_VARIABLE_SIZE | TRACK_ID_GAPS)) || (sectorsPerTrack > TRACK_CACHE_MAX_SPT))
   {
-    if (sectorsTable[idx] != 0xFFFFFFFFUL) // undefined
-    {
-      if ((BYTE)(sectorsTable[idx] >> 16) < startSector)
-      {
-        startSector = (BYTE)(sectorsTable[idx] >> 16);
-        idx2 = idx;
-      }
-    }    
-    idx++;
+    return table;
   }
   
-  // next sector
-  idx = idx2 + 1;
-  BYTE nextSector = 0;
-  while (idx < tableCount)
-  {
-    if (sectorsTable[idx] == 0xFFFFFFFFUL)
-    {
-      idx++;
-      continue;
-    }
-    
-    nextSector = (BYTE)(sectorsTable[idx] >> 16);
-    break;
-  }
+  // cache only if one whole revolution of IDs is present (no gaps), all with the same SDH and cylinder
+  WD42C22::TrackInfo info = {};
+  info.SDH = (BYTE)(table[0] >> 24);
+  info.LogicalCylinder = (WORD)table[0];
+  info.Geometry = geometry;
   
-  if (idx < tableCount)
-  {   
-    if ((nextSector > startSector) && ((nextSector - startSector) == 1))
-    {
-      // confirmed sequential
-      result = 1;
-      return true;
-    }
-    
-    // nope, try to compute from thisSector
-    BYTE interleave = 1;
-    idx2 = idx;
-    while (idx2 < tableCount)
+  for (BYTE idx = 0; idx < sectorsPerTrack; idx++)
+  {
+    const DWORD& data = table[idx];
+    if ((data == 0xFFFFFFFFUL) || ((data & 0xFF00FFFFUL) != (table[0] & 0xFF00FFFFUL)))
     {
-      if ((BYTE)(sectorsTable[idx2++] >> 16) != startSector+1)
-      {
-        interleave++;
-      }
-      else
-      {
-        break;
-      }
+      return table;
     }
     
-    // double-check if nextSector is advanced by the same factor,
-    // or that it loops around the starting sector
-    idx2 = idx+interleave;
-    
-    if ((idx2 < tableCount) && (interleave < sectorsPerTrack))
-    {
-      const BYTE next = (BYTE)(sectorsTable[idx2] >> 16);
-      if ((next == nextSector+1) || (next == startSector))
-      {
-        result = interleave;
-        return true;
-      }
-    }
+    info.Sectors[idx] = (BYTE)(data >> 16);
   }
   
-  // could not determine interleave, fall back to sequential
-  result = 1;
-  return false;
+  wdc->cacheTrack(info);
+  return table;
 }
-
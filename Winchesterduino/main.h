@@ -8,8 +8,28 @@ void InitializeDisk();
 void MainLoop();
 
 // helpers
-DWORD* CalculateSectorsPerTrack(BYTE sdh,
-                                BYTE& sectorsPerTrack, WORD& tableCount,
-                                bool& headMismatch, bool& cylinderMismatch, bool& variableSectorSize);
+DWORD* ScanTrack(BYTE& sdh, WORD& tableCount, WD42C22::TrackGeometry& geometry);
+DWORD* CalculateSectorsPerTrack(WORD& tableCount, WD42C22::TrackGeometry& geometry);
+bool CheckRotationStable(WORD cylinder);
 
-bool CalculateInterleave(const DWORD* sectorsTable, WORD tableCount, BYTE sectorsPerTrack, BYTE& result);
\ No newline at end of file
+// track traversal of the whole-disk commands (image read, scan, analyze), TRAVERSAL_ORDER in config.h
+#define TRAVERSAL_LINEAR       0         // all heads of a cylinder from head 0, cylinders upwards
+#define TRAVERSAL_SERPENTINE   1         // heads in alternating order on every other cylinder, no head switch across a step
+#define TRAVERSAL_SWEEP        2         // serpentine, cylinders from the end of the range nearer to the heads
+
+struct Traversal
+{
+  WORD StartCylinder;
+  WORD EndCylinder;
+  WORD Cylinder;   // current track
+  BYTE Head;
+  BYTE FirstHead;  // head visited first on the current cylinder
+  bool Downwards;  // cylinders from EndCylinder down to StartCylinder
+  bool HeadsDown;  // heads of the current cylinder from the highest one down
+  bool Done;
+};
+
+void TraversalBegin(Traversal& traversal, WORD startCylinder, WORD endCylinder);
+bool TraversalNext(Traversal& traversal);  // false if there are no more tracks
+bool TraversalPeek(const Traversal& traversal, WORD& cylinder, BYTE& head);
+WORD TraversalHome();                      // where to rest the heads between commands
\ No newline at end of file
@@ -0,0 +1,49 @@
+// Winchesterduino (c) 2025 J. Bogin, http://boginjr.com
+// Static memory pool for sector tables and scratch buffers
+
+#include "config.h"
+
+// scratch declared as DWORDs, so that a sectors table can be put there as well
+DWORD poolTables[POOL_TABLES][POOL_TABLE_ENTRIES]   = {0};
+DWORD poolScratch[POOL_SCRATCH_SIZE / sizeof(DWORD)] = {0};
+BYTE  poolTxRing[POOL_TX_RING_SIZE] = {0};
+BYTE  poolStream[POOL_STREAM_SIZE]  = {0};
+
+// provided by avr-libc
+extern char  __heap_start;
+extern char* __brkval;
+
+DWORD* PoolGetTable(BYTE index)
+{
+  return poolTables[index % POOL_TABLES];
+}
+
+BYTE* PoolGetScratch()
+{
+  return (BYTE*)poolScratch;
+}
+
+BYTE* PoolGetTxRing()
+{
+  return poolTxRing;
+}
+
+BYTE* PoolGetStream()
+{
+  return poolStream;
+}
+
+WORD PoolGetFreeRam()
+{
+  char top;
+  return (WORD)(&top - (__brkval ? __brkval : &__heap_start));
+}
+
+void PoolShowReport()
+{
+  // the worst case: imaging with XMODEM-1K, whose packet buffer is the only large allocation on the heap
+  const WORD freeRam = PoolGetFreeRam();
+  ui->print(Progmem::getString(Progmem::uiShowRamPool), (WORD)POOL_SIZE);
+  ui->print(Progmem::getString(Progmem::uiShowRamFree), freeRam);
+  ui->print(Progmem::getString(Progmem::uiShowRamWorst), (freeRam > POOL_XMODEM_1K_SIZE) ? (freeRam - POOL_XMODEM_1K_SIZE) : 0);
+}
\ No newline at end of file
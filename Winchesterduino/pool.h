@@ -0,0 +1,24 @@
+// Winchesterduino (c) 2025 J. Bogin, http://boginjr.com
+// Static memory pool for sector tables and scratch buffers
+
+#pragma once
+#include "config.h"
+
+// peak footprint known at link time, no heap use (and fragmentation) for these
+#define POOL_TABLE_ENTRIES     100       // sector IDs in one table, filled by fillSectorsTable()
+#define POOL_TABLES            2         // CalculateSectorsPerTrack(): current attempt and best one so far, or one WDI sector map up to 200 entries
+#define POOL_SCRATCH_SIZE      512       // format interleave table, setBadSector() sectors table, hexdump chunk
+#define POOL_TX_RING_SIZE      1280      // serial transmit ring of the port image transfers go to: one whole XMODEM-1K packet and some slack
+#define POOL_STREAM_SIZE       416       // WDI records encoded during image reads, the largest: track header and a map of 100 sectors
+#define POOL_SIZE              (POOL_TABLE_ENTRIES*POOL_TABLES*sizeof(DWORD) + POOL_SCRATCH_SIZE + POOL_TX_RING_SIZE + POOL_STREAM_SIZE)
+
+// largest heap allocation done afterwards: XMODEM-1K packet buffer (1024 data + 3 header + 2 CRC)
+#define POOL_XMODEM_1K_SIZE    1029
+
+DWORD* PoolGetTable(BYTE index);         // POOL_TABLE_ENTRIES each, consecutive in memory
+BYTE*  PoolGetScratch();                 // POOL_SCRATCH_SIZE bytes, also fits one sectors table
+BYTE*  PoolGetTxRing();                  // POOL_TX_RING_SIZE bytes, owned by the USART driver for good (with DATA_CHANNEL 0 it is the console's), never scratch
+BYTE*  PoolGetStream();                  // POOL_STREAM_SIZE bytes, the read disk encoder output
+
+WORD   PoolGetFreeRam();                 // between heap and stack, now
+void   PoolShowReport();
\ No newline at end of file
@@ -69,6 +69,7 @@ public:
     uiTestingWDC,
     uiWaitingReady,
     uiSeekingToCyl0,
+    uiRecalibrateTime,
     uiMinimalMode1,
     uiMinimalMode2,
     uiMinimalMode3,
@@ -103,6 +104,14 @@ public:
     uiShowLZStatus,
     uiShowLZ,
     uiShowSeekMode,
+    uiSetupAskProfile,
+    uiShowSeekProfile,
+    uiShowProfileConstant,
+    uiShowProfileRamped,
+    uiShowProfileBurst,
+    uiShowRamPool,
+    uiShowRamFree,
+    uiShowRamWorst,
     
     // minimal mode
     uiMinimalModeSeek1,
@@ -120,6 +129,7 @@ public:
     optionDos,
     optionSeektest,
     optionPark,
+    optionRotation,
     
     // analyze command
     analyzePrintOrder,
@@ -155,6 +165,16 @@ public:
     formatBadBlocks,
     formatProgress,
     formatComplete,
+    formatBenchAsk,
+    formatBenchMax,
+    formatBenchPath,
+    formatBenchResult,
+    formatBenchErrors,
+    formatBenchBest,
+    formatSkew,
+    formatSkewHead,
+    formatSkewCyl,
+    formatSkewResult,
     
     // scan command
     scanWarning1,
@@ -170,12 +190,34 @@ public:
     seektestBackForth,
     seektestButterfly,
     seektestRandom,
+    seektestAskExport,
+    seektestExportHeader,
+    seektestExportLine,
+    seektestTimes,
+    seektestTrackToTrack,
+    seektestThirdStroke,
+    seektestFullStroke,
+    seektestStrokeTime,
+    seektestHistogram,
+    seektestBucket,
+    seektestBucketOver,
     
     // park command
     parkSuccess, 
     parkPowerdownSafe, 
     parkContinue,
     parkRecalibrating,
+    parkRecalibrated,
+    
+    // rotation command
+    rotationFailed,
+    rotationRPM,
+    rotationPeriod,
+    rotationJitter,
+    rotationSectors,
+    rotationGap,
+    rotationUnstable,
+    rotationContinue,
     
     // image file transfer
     imgReadWholeDisk,
@@ -197,6 +239,7 @@ public:
     imgXmodemErrVar1,
     imgXmodemErrVar2,
     imgXmodemErrPart,
+    imgXmodemErrSpt,
     imgWriteHeader,
     imgWriteComment,
     imgWriteDone,
@@ -218,6 +261,13 @@ public:
     imgImageStats,
     imgRunScan,
     imgRestoreParams,
+    imgRevolutions,
+    imgBusCycles,
+    imgCommandStats,
+    imgLinkBusy,
+    imgDataChannel,
+    imgDataStriped,
+    imgTrackProgress,
     
     // DOS
     dosInvalidSsize,
@@ -310,6 +360,7 @@ private:
   PROGMEM_STR m_uiTestingWDC[]       PROGMEM = "Testing WD42C22 and its buffer RAM...";
   PROGMEM_STR m_uiWaitingReady[]     PROGMEM = "Waiting until drive becomes /READY...";
   PROGMEM_STR m_uiSeekingToCyl0[]    PROGMEM = "Determining position of cylinder 0...";
+  PROGMEM_STR m_uiRecalibrateTime[]  PROGMEM = " (%lu ms)";
   PROGMEM_STR m_uiMinimalMode1[]     PROGMEM = "WDC disk controller not present, or not working properly.\r\n";
   PROGMEM_STR m_uiMinimalMode2[]     PROGMEM = "Running in minimal mode. Only basic seeking is supported.\r\n";
   PROGMEM_STR m_uiMinimalMode3[]     PROGMEM = "Use a logic analyzer on the 'raw TTL read data' connector.\r\n";
@@ -344,6 +395,14 @@ private:
   PROGMEM_STR m_uiShowLZStatus[]     PROGMEM = "\r\nAutopark on powerdown: ";
   PROGMEM_STR m_uiShowLZ[]           PROGMEM = "\r\nLanding zone cylinder: %u";
   PROGMEM_STR m_uiShowSeekMode[]     PROGMEM = "\r\nDrive seeking mode:    ";
+  PROGMEM_STR m_uiSetupAskProfile[]  PROGMEM = "Step pulses: (C)onstant / (R)amped / (B)uffered burst: ";
+  PROGMEM_STR m_uiShowSeekProfile[]  PROGMEM = "Step rate profile:     ";
+  PROGMEM_STR m_uiShowProfileConstant[] PROGMEM = "constant\r\n";
+  PROGMEM_STR m_uiShowProfileRamped[] PROGMEM = "ramped\r\n";
+  PROGMEM_STR m_uiShowProfileBurst[] PROGMEM = "buffered burst\r\n";
+  PROGMEM_STR m_uiShowRamPool[]      PROGMEM = "Static buffer pool:    %u bytes";
+  PROGMEM_STR m_uiShowRamFree[]      PROGMEM = "\r\nFree RAM:              %u bytes";
+  PROGMEM_STR m_uiShowRamWorst[]     PROGMEM = "\r\nFree RAM, worst case:  %u bytes (imaging, XMODEM-1K)\r\n";
   
 // minimal mode
   PROGMEM_STR m_uiMinimalModeSeek1[] PROGMEM = "Seek to cylinder (0-2047): ";
@@ -361,6 +420,7 @@ private:
   PROGMEM_STR m_optionDos[]          PROGMEM = "(I)nspect DOS primary partition\r\n";
   PROGMEM_STR m_optionSeektest[]     PROGMEM = "(D)rive heads seek test / exercise\r\n";
   PROGMEM_STR m_optionPark[]         PROGMEM = "(P)ark drive heads\r\n";  
+  PROGMEM_STR m_optionRotation[]     PROGMEM = "(T)ime disk rotation\r\n";
   
 // analyze command
   PROGMEM_STR m_analyzePrintOrder[]  PROGMEM = "Show logical sector numbers (interleave tables)? Y/N: ";
@@ -390,12 +450,22 @@ private:
 // format command
   PROGMEM_STR m_formatWarning[]      PROGMEM = "\r\nDestroys data between specified cylinders.";
   PROGMEM_STR m_formatSpt[]          PROGMEM = "Sectors per track (%u-%u): ";
-  PROGMEM_STR m_formatInterleave[]   PROGMEM = "Interleave (1: none): ";
+  PROGMEM_STR m_formatInterleave[]   PROGMEM = "Interleave (1: none, 0: benchmark): ";
   PROGMEM_STR m_formatStartSector[]  PROGMEM = "Starting sector (0-%u, default 1): ";
   PROGMEM_STR m_formatVerify[]       PROGMEM = "Verify during format? Y/N: ";
   PROGMEM_STR m_formatBadBlocks[]    PROGMEM = "Mark *any* errors as bad blocks? Y/N: ";
   PROGMEM_STR m_formatProgress[]     PROGMEM = "\rFormatting cyl %u head %u... ";
   PROGMEM_STR m_formatComplete[]     PROGMEM = "\r\n\r\nFormat complete\r\n";
+  PROGMEM_STR m_formatBenchAsk[]     PROGMEM = "Benchmark reformats cylinder %u head 0 once all is asked.\r\n";
+  PROGMEM_STR m_formatBenchMax[]     PROGMEM = "Try interleaves 1 to (2-%u): ";
+  PROGMEM_STR m_formatBenchPath[]    PROGMEM = "Data goes to (S)erial at %lu bps or (M)CU only (DOS/FatFs): ";
+  PROGMEM_STR m_formatBenchResult[]  PROGMEM = "\rInterleave %2u:1 %4lu.%02lu KB/s";
+  PROGMEM_STR m_formatBenchErrors[]  PROGMEM = ", %u read error(s)";
+  PROGMEM_STR m_formatBenchBest[]    PROGMEM = "\r\nFastest: %u:1, formatting with it.\r\n";
+  PROGMEM_STR m_formatSkew[]         PROGMEM = "Skew: (N)one, (M)easure, (E)nter: ";
+  PROGMEM_STR m_formatSkewHead[]     PROGMEM = "Head skew (0-%u): ";
+  PROGMEM_STR m_formatSkewCyl[]      PROGMEM = "Cylinder skew (0-%u): ";
+  PROGMEM_STR m_formatSkewResult[]   PROGMEM = "Head skew %u, cylinder skew %u sector(s).\r\n";
   
 // scan command
   PROGMEM_STR m_scanWarning1[]       PROGMEM = "\r\nUse this to rescan bad sectors on a known good drive,\r\n";
@@ -411,12 +481,34 @@ private:
   PROGMEM_STR m_seektestBackForth[]  PROGMEM = "Back and forth seeks";
   PROGMEM_STR m_seektestButterfly[]  PROGMEM = "Full butterfly tests";
   PROGMEM_STR m_seektestRandom[]     PROGMEM = "Random seeks";
+  PROGMEM_STR m_seektestAskExport[]  PROGMEM = "\r\nExport each seek time over serial as CSV? Y/N: ";
+  PROGMEM_STR m_seektestExportHeader[] PROGMEM = "distance,microseconds\r\n";
+  PROGMEM_STR m_seektestExportLine[] PROGMEM = "%u,%lu\r\n";
+  PROGMEM_STR m_seektestTimes[]      PROGMEM = "\r\nSeek times, first step pulse to seek complete:\r\n";
+  PROGMEM_STR m_seektestTrackToTrack[] PROGMEM = "Track-to-track:   ";
+  PROGMEM_STR m_seektestThirdStroke[] PROGMEM = "One-third stroke: ";
+  PROGMEM_STR m_seektestFullStroke[] PROGMEM = "Full stroke:      ";
+  PROGMEM_STR m_seektestStrokeTime[] PROGMEM = "avg %lu.%02lu ms, min %lu.%02lu ms, max %lu.%02lu ms\r\n";
+  PROGMEM_STR m_seektestHistogram[]  PROGMEM = "\r\nHistogram of all %lu seeks:\r\n";
+  PROGMEM_STR m_seektestBucket[]     PROGMEM = "  < %4lu ms: %lu\r\n";
+  PROGMEM_STR m_seektestBucketOver[] PROGMEM = " >= %4lu ms: %lu\r\n";
   
 // park command
   PROGMEM_STR m_parkSuccess[]        PROGMEM = "\rDrive heads sent to landing zone cylinder %u.\r\n";
   PROGMEM_STR m_parkPowerdownSafe[]  PROGMEM = "After powerdown, it is safe to relocate the drive.\r\n";
   PROGMEM_STR m_parkContinue[]       PROGMEM = "\r\nOr, press any key to resume working with the drive.\r\n";
   PROGMEM_STR m_parkRecalibrating[]  PROGMEM = "Recalibrating, please wait...";
+  PROGMEM_STR m_parkRecalibrated[]   PROGMEM = "Recalibrated in %lu ms.\r\n";
+  
+// rotation command
+  PROGMEM_STR m_rotationFailed[]     PROGMEM = "No sector IDs found, the track needs to be formatted.\r\n";
+  PROGMEM_STR m_rotationRPM[]        PROGMEM = "Rotation speed:   %lu.%02lu RPM\r\n";
+  PROGMEM_STR m_rotationPeriod[]     PROGMEM = "Revolution:       %lu us, min %lu us, max %lu us\r\n";
+  PROGMEM_STR m_rotationJitter[]     PROGMEM = "Jitter:           %lu us (%lu.%02lu%%)\r\n";
+  PROGMEM_STR m_rotationSectors[]    PROGMEM = "Sector IDs:       %u per track, %lu us apart\r\n";
+  PROGMEM_STR m_rotationGap[]        PROGMEM = "Track gap:        %lu us, before sector %u\r\n";
+  PROGMEM_STR m_rotationUnstable[]   PROGMEM = "Unstable spindle: %lu.%02lu RPM, %lu.%02lu%% jitter!\r\n";
+  PROGMEM_STR m_rotationContinue[]   PROGMEM = "Continue anyway? Y/N: ";
     
 // image file transfer
   PROGMEM_STR m_imgReadWholeDisk[]   PROGMEM = "Read whole disk? (normally Yes) Y/N: ";
@@ -425,7 +517,7 @@ private:
   PROGMEM_STR m_imgXmodemPrefix[]    PROGMEM = "XMODEM: ";
   PROGMEM_STR m_imgXmodem1kPrefix[]  PROGMEM = "XMODEM-1K: ";
   PROGMEM_STR m_imgXmodemWaitSend[]  PROGMEM = "OK to launch Send\r\nTimeout 4 minutes\r\n";
-  PROGMEM_STR m_imgXmodemWaitRecv[]  PROGMEM = "OK to launch Receive\r\nTimeout 4 minutes\r\n";
+  PROGMEM_STR m_imgXmodemWaitRecv[]  PROGMEM = "OK to launch Receive (XMODEM-G streams)\r\nTimeout 4 minutes\r\n";
   PROGMEM_STR m_imgXmodemXferEnd[]   PROGMEM = "\rEnd of transfer";
   PROGMEM_STR m_imgXmodemXferFail[]  PROGMEM = "\rTransfer aborted";
   PROGMEM_STR m_imgXmodemErrPacket[] PROGMEM = "Invalid XMODEM data packet";
@@ -438,6 +530,7 @@ private:
   PROGMEM_STR m_imgXmodemErrVar1[]   PROGMEM = "WD42C22 cannot format varying sector sizes in 1 track!";
   PROGMEM_STR m_imgXmodemErrVar2[]   PROGMEM = "WD42C22 cannot format varying cyl/head numbers in 1 track!";
   PROGMEM_STR m_imgXmodemErrPart[]   PROGMEM = "Nothing to write within the supplied start/end cylinders";
+  PROGMEM_STR m_imgXmodemErrSpt[]    PROGMEM = "More sectors per track in image than supported";
   PROGMEM_STR m_imgWriteHeader[]     PROGMEM = "WDI file created by Winchesterduino, (c) J. Bogin\r\n";
   PROGMEM_STR m_imgWriteComment[]    PROGMEM = "Add file comment (max %u characters per line)\r\n";
   PROGMEM_STR m_imgWriteDone[]       PROGMEM = "Type 2 empty newlines when done\r\n";
@@ -459,6 +552,13 @@ private:
   PROGMEM_STR m_imgImageStats[]      PROGMEM = "WDI image stats:\r\n";
   PROGMEM_STR m_imgRunScan[]         PROGMEM = "\r\nRun \"Mark data errors\" to re-scan defects on this disk.\r\n";
   PROGMEM_STR m_imgRestoreParams[]   PROGMEM = "(R)estore last disk settings or (K)eep those from image?: ";
+  PROGMEM_STR m_imgRevolutions[]     PROGMEM = "Read in %lu.%02lu disk revolutions per track (avg.)\r\n";
+  PROGMEM_STR m_imgBusCycles[]       PROGMEM = "WDC bus cycles: %lu, saved by register shadows: %lu\r\n";
+  PROGMEM_STR m_imgCommandStats[]    PROGMEM = "WDC command %02Xh: %lux, avg. %lu us, max. %lu us\r\n";
+  PROGMEM_STR m_imgLinkBusy[]        PROGMEM = "Serial link busy: %lu%% of %lu s, buffer full: %lu ms\r\n";
+  PROGMEM_STR m_imgDataChannel[]     PROGMEM = "Data channel: USART%u at %lu bps, Esc aborts\r\n";
+  PROGMEM_STR m_imgDataStriped[]     PROGMEM = "Striped: odd frames on USART%u, even on USART%u\r\n";
+  PROGMEM_STR m_imgTrackProgress[]   PROGMEM = "\rTransferring cyl %u head %u... ";
   
 // DOS  
   PROGMEM_STR m_dosInvalidSsize[]    PROGMEM = "Invalid sector size on track 0 (%u bytes)";
@@ -500,7 +600,7 @@ private:
                                                   m_uiErrNoAddrMark, m_uiErrNoSectorID, m_uiErrDataCRC, m_uiErrDataECC, m_uiErrBadBlock,
                                                   m_uiErrEccCorrected,
 
-                                                  m_uiSplash, m_uiBuild, m_uiTestingWDC, m_uiWaitingReady, m_uiSeekingToCyl0,
+                                                  m_uiSplash, m_uiBuild, m_uiTestingWDC, m_uiWaitingReady, m_uiSeekingToCyl0, m_uiRecalibrateTime,
                                                   m_uiMinimalMode1, m_uiMinimalMode2, m_uiMinimalMode3, m_uiSetupParams, 
                                                   m_uiSetupDataMode, m_uiSetupDataVerify, m_uiSetupCylinders, m_uiSetupHeads,
                                                   m_uiSetupAskRWC, m_uiSetupCylRWC, m_uiSetupAskPrecomp, m_uiSetupCylPrecomp,
@@ -509,11 +609,14 @@ private:
                                                   m_uiShowVerifyCRC, m_uiShowVerifyECC, m_uiShowVerifyECC56, m_uiShowDataMode, 
                                                   m_uiShowVerifyMode, m_uiShowCylinders, m_uiShowHeads, m_uiShowRWC, m_uiShowPrecomp,
                                                   m_uiShowLZStatus, m_uiShowLZ, m_uiShowSeekMode,
+                                                  m_uiSetupAskProfile, m_uiShowSeekProfile, m_uiShowProfileConstant, m_uiShowProfileRamped, m_uiShowProfileBurst,
+                                                  m_uiShowRamPool, m_uiShowRamFree, m_uiShowRamWorst,
                                                   
                                                   m_uiMinimalModeSeek1, m_uiMinimalModeSeek2, m_uiMinimalModeSeek3,
                                                   
                                                   m_optionAnalyze, m_optionHexdump, m_optionFormat, m_optionScan, m_optionReadImage,
                                                   m_optionWriteImage, m_optionShowParams, m_optionDos, m_optionSeektest, m_optionPark,
+                                                  m_optionRotation,
                                                   
                                                   m_analyzePrintOrder, m_analyzeNoSectors, m_analyzeSectorInfo, m_analyzeSectorInfo2,
                                                   m_analyzeSectorInfo3, m_analyzeSectorInfo4, m_analyzeSectorInfo5, 
@@ -525,24 +628,33 @@ private:
                                                   
                                                   m_formatWarning, m_formatSpt, m_formatInterleave, m_formatStartSector,
                                                   m_formatVerify, m_formatBadBlocks, m_formatProgress, m_formatComplete,
+                                                  m_formatBenchAsk, m_formatBenchMax, m_formatBenchPath, m_formatBenchResult,
+                                                  m_formatBenchErrors, m_formatBenchBest, m_formatSkew, m_formatSkewHead, m_formatSkewCyl,
+                                                  m_formatSkewResult,
                                                   
                                                   m_scanWarning1, m_scanWarning2, m_scanWarning3, m_scanMarginal, m_scanProgress,
                                                   
                                                   m_seektestLegacy, m_seektestRepeats, m_seektestProgress, m_seektestBackForth,
-                                                  m_seektestButterfly, m_seektestRandom,
+                                                  m_seektestButterfly, m_seektestRandom, m_seektestAskExport, m_seektestExportHeader,
+                                                  m_seektestExportLine, m_seektestTimes, m_seektestTrackToTrack, m_seektestThirdStroke,
+                                                  m_seektestFullStroke, m_seektestStrokeTime, m_seektestHistogram, m_seektestBucket,
+                                                  m_seektestBucketOver,
+                                                  
+                                                  m_parkSuccess, m_parkPowerdownSafe, m_parkContinue, m_parkRecalibrating, m_parkRecalibrated,
                                                   
-                                                  m_parkSuccess, m_parkPowerdownSafe, m_parkContinue, m_parkRecalibrating,
+                                                  m_rotationFailed, m_rotationRPM, m_rotationPeriod, m_rotationJitter, m_rotationSectors,
+                                                  m_rotationGap, m_rotationUnstable, m_rotationContinue,
                                                   
                                                   m_imgReadWholeDisk, m_imgWriteWholeDisk, m_imgXmodem1k, m_imgXmodemPrefix, m_imgXmodem1kPrefix,
                                                   m_imgXmodemWaitSend, m_imgXmodemWaitRecv, m_imgXmodemXferEnd, m_imgXmodemXferFail,                                                  
                                                   m_imgXmodemErrPacket, m_imgXmodemErrHeader, m_imgXmodemErrParams, m_imgXmodemErrSecTyp,
                                                   m_imgXmodemErrMFMRLL, m_imgXmodemErrCyls, m_imgXmodemErrHeads,                                                  
-                                                  m_imgXmodemErrVar1, m_imgXmodemErrVar2, m_imgXmodemErrPart, m_imgWriteHeader, m_imgWriteComment, 
+                                                  m_imgXmodemErrVar1, m_imgXmodemErrVar2, m_imgXmodemErrPart, m_imgXmodemErrSpt, m_imgWriteHeader, m_imgWriteComment, 
                                                   m_imgWriteDone, m_imgWriteEnterEsc, m_imgBadBlocks, m_imgBadBlocksKnown, m_imgDataCorrected,
                                                   m_imgDataErrors, m_imgDataErrorsConv, m_imgBadTracks, m_imgOverrideWrite1, 
                                                   m_imgOverrideWrite2, m_imgOverrideWrite3, m_imgBadBloxOption1, m_imgBadBloxOption2,
                                                   m_imgDataErrorsOpt1, m_imgDataErrorsOpt2, m_imgDiskStats, m_imgImageStats, m_imgRunScan,
-                                                  m_imgRestoreParams,
+                                                  m_imgRestoreParams, m_imgRevolutions, m_imgBusCycles, m_imgCommandStats, m_imgLinkBusy, m_imgDataChannel, m_imgDataStriped, m_imgTrackProgress,
                                                   
                                                   m_dosInvalidSsize, m_dosFsMountError, m_dosDiskError, m_dosFileNotFound,
                                                   m_dosPathNotFound, m_dosDirectoryFull, m_dosFileExists, m_dosFsError, 
@@ -18,32 +18,56 @@ DSTATUS disk_initialize(BYTE pdrv)
 
 DRESULT disk_read(BYTE pdrv, BYTE *buf, DWORD sec, UINT count)
 { 
-  // FATFS operates in single sectors
-  if ((count != 1) || (sec > DOSGetTotalSectorCount()))
+  // FATFS mostly operates in single sectors, but multi-sector file reads are done in bursts up to the end of a track
+  if (!count || ((sec + count) > DOSGetTotalSectorCount()))
   {
     return RES_PARERR; 
   }
   
-  WORD cyl;
-  BYTE head;
-  BYTE sector;
-  DOSConvertLogicalSectorToCHS(sec, cyl, head, sector);
-  
-  wdc->seekDrive(cyl, head);
-  wdc->readSector(sector, DOSGetSectorSize());
-  
-  // allow ECC
-  if (wdc->getLastError() && (wdc->getLastError() != WDC_CORRECTED))
+  while (count)
   {
-    return RES_ERROR;
-  }
-  
-  wdc->sramBeginBufferAccess(false, 0);
-  for (WORD idx = 0; idx < DOSGetSectorSize(); idx++)
-  {
-    buf[idx] = wdc->sramReadByteSequential();
+    WORD cyl;
+    BYTE head;
+    BYTE sector;
+    DOSConvertLogicalSectorToCHS(sec, cyl, head, sector);
+    
+    BYTE burst = DOSGetSectorsPerTrack() - (BYTE)(sec % DOSGetSectorsPerTrack());
+    if (burst > count)
+    {
+      burst = (BYTE)count;
+    }
+    
+    // ECC corrections go straight into buf, instead of into SRAM first
+    wdc->seekDrive(cyl, head);
+    wdc->setDeferredCorrection(true);
+    burst = wdc->readSectors(sector, burst, DOSGetSectorSize());
+    if (wdc->getLastError() && (wdc->getLastError() < 4)) // WDC timeout, drive not ready, writefault
+    {
+      wdc->setDeferredCorrection(false);
+      return RES_ERROR;
+    }
+    
+    // allow ECC
+    for (BYTE index = 0; index < burst; index++)
+    {
+      if (wdc->getSectorStatus(index) && (wdc->getSectorStatus(index) != WDC_CORRECTED))
+      {
+        wdc->setDeferredCorrection(false);
+        return RES_ERROR;
+      }
+    }
+    
+    const WORD burstBytes = (WORD)burst * DOSGetSectorSize();
+    wdc->sramBeginBufferAccess(false, 0);
+    wdc->sramReadBlock(buf, burstBytes);
+    wdc->sramFinishBufferAccess();
+    wdc->applyCorrections(buf, 0, burstBytes);
+    wdc->setDeferredCorrection(false);
+    
+    buf += burstBytes;
+    sec += burst;
+    count -= burst;
   }
-  wdc->sramFinishBufferAccess();
 
   return RES_OK;
 }
@@ -63,10 +87,7 @@ DRESULT disk_write(BYTE pdrv, BYTE *buf, DWORD sec, UINT count)
   DOSConvertLogicalSectorToCHS(sec, cyl, head, sector);
   
   wdc->sramBeginBufferAccess(true, 0);
-  for (WORD idx = 0; idx < DOSGetSectorSize(); idx++)
-  {
-    wdc->sramWriteByteSequential(buf[idx]);
-  }
+  wdc->sramWriteBlock(buf, DOSGetSectorSize());
   wdc->sramFinishBufferAccess();
   
   wdc->seekDrive(cyl, head);
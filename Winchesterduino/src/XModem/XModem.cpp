@@ -1,4 +1,6 @@
 // Bogin: added XMODEM-1K packet size
+//        and the streaming (XMODEM-G) transmit mode: no ACK turnaround after each frame
+//        CRC by avr-libc's _crc_xmodem_update() where available, a fraction of the bitwise loop's cycles
 // This code was taken from: https://github.com/mgk/arduino-xmodem
 // (https://code.google.com/archive/p/arduino-xmodem)
 // which was released under GPL V3:
@@ -20,6 +22,9 @@
 
 #include <stdio.h>
 #include <string.h>
+#ifdef __AVR__
+#include <util/crc16.h>
+#endif
 
 #include "XModem.h"
 const unsigned char XModem::NACK = 21;
@@ -28,6 +33,7 @@ const unsigned char XModem::SOH =  1;
 const unsigned char XModem::STX =  2;
 const unsigned char XModem::EOT =  4;
 const unsigned char XModem::CAN =  0x18;
+const unsigned char XModem::STREAM = 'G';
 
 const int XModem::m_receiveDelay=7000;
 const int XModem::m_rcvRetryLimit = 10;
@@ -273,6 +279,10 @@ bool XModem::receive()
 unsigned short XModem::crc16_ccitt(char *buf, int size)
 {
 	unsigned short crc = 0;
+#ifdef __AVR__
+	while (--size >= 0)
+		crc = _crc_xmodem_update(crc, (unsigned char)*buf++);
+#else
 	while (--size >= 0) {
 		int i;
 		crc ^= (unsigned short) *buf++ << 8;
@@ -282,6 +292,7 @@ unsigned short XModem::crc16_ccitt(char *buf, int size)
 			else
 				crc <<= 1;
 	}
+#endif
 	return crc;
 }
 unsigned char XModem::generateChkSum(const char *buf, int len)
@@ -347,7 +358,7 @@ bool XModem::transmitFrames(transfer_t transfer)
 		if (transfer == ChkSum) {
                   m_buffer[3+m_blockSize] = generateChkSum(m_buffer+3, m_blockSize);
                   sendData(m_buffer, 3+m_blockSize+1);
-		} else {
+		} else { // Crc, CrcStream
                   unsigned short crc;
                   crc = crc16_ccitt(m_buffer+3, m_blockSize);
                   m_buffer[3+m_blockSize+0] = (unsigned char)(crc >> 8);
@@ -355,6 +366,15 @@ bool XModem::transmitFrames(transfer_t transfer)
                   sendData(m_buffer, 3+m_blockSize+2);
 		}
 
+		//streaming - no turnaround, the receiver can only cancel
+		if (transfer == CrcStream) {
+			if (dataAvail(0) && (dataRead(0) == XModem::CAN))
+				return false;
+			m_blockNo++;
+			m_blockNoExt++;
+			continue;
+		}
+
 		//TO DO - wait NACK or CAN or ACK
 		int ret = dataRead(XModem::m_receiveDelay);
 		switch(ret)
@@ -389,6 +409,8 @@ bool XModem::transmit()
 				return transmitFrames(Crc);
 			if(sym == XModem::NACK)
 				return transmitFrames(ChkSum);
+			if(sym == XModem::STREAM)
+				return transmitFrames(CrcStream);
 		}
 		retry++;
 	}	
@@ -1,4 +1,5 @@
 // Bogin: added XMODEM-1K packet size
+//        and the streaming (XMODEM-G) transmit mode: no ACK turnaround after each frame
 // This code was taken from: https://code.google.com/archive/p/arduino-xmodem
 // (https://code.google.com/archive/p/arduino-xmodem)
 // which was released under GPL V3:
@@ -23,7 +24,8 @@
 
 typedef enum {
 	Crc,
-	ChkSum	
+	ChkSum,
+	CrcStream	// receiver asked with 'G': CRC frames back to back, only CAN is expected in between
 } transfer_t;
 
 
@@ -73,6 +75,7 @@ class XModem {
     static const unsigned char STX;
 		static const unsigned char EOT;
 		static const unsigned char CAN;
+		static const unsigned char STREAM;
 	
 		XModem(int (*recvChar)(int), void (*sendData)(const char *data, int len), 
   			        bool (*dataHandler)(unsigned long, char*, int),
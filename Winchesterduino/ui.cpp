@@ -6,23 +6,329 @@
 // reset by null pointer function call
 void (*resetBoard)() = NULL;
 
+// USARTs driven by registers here: Serial is never referenced, so HardwareSerial (and its 64 byte buffers) is not linked in
+// and the vectors below are ours; USART0 is the console, DATA_CHANNEL and DATA_CHANNEL_STRIPE carry the image transfers if set
+#define XON  0x11
+#define XOFF 0x13
+
+#if DATA_CHANNEL_STRIPE && (!DATA_CHANNEL || (DATA_CHANNEL_STRIPE == DATA_CHANNEL))
+#error "DATA_CHANNEL_STRIPE needs DATA_CHANNEL set, to another USART"
+#endif
+
+struct UsartPort
+{
+  volatile BYTE* Ucsra;
+  volatile BYTE* Ucsrb;
+  volatile WORD* Ubrr;
+  volatile BYTE* Udr;
+  
+  // transmit ring, drained by the data register empty interrupt
+  BYTE* TxRing;
+  WORD TxSize;
+  volatile WORD TxHead;             // next free, only moved by txWrite()
+  volatile WORD TxTail;             // next to send, only moved by the ISR
+  volatile DWORD TxSent;
+  volatile bool TxPaused;           // XOFF from the other side
+  volatile BYTE TxPriority;         // our own XON or XOFF, goes out before the ring (and even if paused)
+  
+  // receive ring, filled by the receive complete interrupt
+  BYTE* RxRing;
+  WORD RxSize;
+  volatile WORD RxHead;             // next free, only moved by the ISR
+  volatile WORD RxTail;             // next to read, only moved by rxRead()
+  volatile bool RxThrottled;        // XOFF sent, XON when drained
+  volatile bool RxBinary;           // XMODEM receive: XON and XOFF from the other side are just data
+};
+UsartPort usartPorts[4];
+
+#if DATA_CHANNEL
+// the pool ring carries the transfers, the console just the progress and the keys
+#define CONSOLE_RING_SIZE 128
+BYTE consoleTxRing[CONSOLE_RING_SIZE];
+BYTE consoleRxRing[CONSOLE_RING_SIZE];
+BYTE dataRxRing[SERIAL_RX_RING_SIZE];
+#if DATA_CHANNEL_STRIPE
+BYTE stripeRxRing[CONSOLE_RING_SIZE]; // nothing but a CAN is expected this way
+const BYTE dataPorts[] = {PORT_DATA, PORT_STRIPE};
+#else
+const BYTE dataPorts[] = {PORT_DATA};
+#endif
+#else
+BYTE consoleRxRing[SERIAL_RX_RING_SIZE];
+const BYTE dataPorts[] = {PORT_CONSOLE};
+#endif
+
+static inline __attribute__((always_inline)) void UsartUdre(UsartPort& port)
+{
+  if (port.TxPriority)
+  {
+    *port.Udr = port.TxPriority;
+    port.TxPriority = 0;
+  }
+  else if ((port.TxTail != port.TxHead) && !port.TxPaused)
+  {
+    WORD tail = port.TxTail;
+    *port.Udr = port.TxRing[tail];
+    port.TxTail = (++tail == port.TxSize) ? 0 : tail;
+    port.TxSent++;
+  }
+  else
+  {
+    *port.Ucsrb &= ~_BV(UDRIE0); // enabled again by txWrite(), or by XON
+  }
+}
+
+static inline __attribute__((always_inline)) void UsartRx(UsartPort& port)
+{
+  const BYTE data = *port.Udr;
+  
+#if SERIAL_XON_XOFF
+  if (!port.RxBinary && ((data == XON) || (data == XOFF)))
+  {
+    port.TxPaused = (data == XOFF);
+    if (!port.TxPaused)
+    {
+      *port.Ucsrb |= _BV(UDRIE0);
+    }
+    return;
+  }
+#endif
+
+  const WORD head = port.RxHead;
+  const WORD next = (head + 1 == port.RxSize) ? 0 : (head + 1);
+  if (next == port.RxTail)
+  {
+    return; // overrun, dropped
+  }
+  port.RxRing[head] = data;
+  port.RxHead = next;
+  
+#if SERIAL_XON_XOFF
+  // ask the other side to pause while there is still room for what its USB bridge has already on the way
+  const WORD used = (next >= port.RxTail) ? (next - port.RxTail) : (port.RxSize - port.RxTail + next);
+  if (!port.RxThrottled && (used >= (port.RxSize / 2)))
+  {
+    port.RxThrottled = true;
+    port.TxPriority = XOFF;
+    *port.Ucsrb |= _BV(UDRIE0);
+  }
+#endif
+}
+
+// registers and vectors of USART n (the bit positions are the same on all four)
+#define USART_REGISTERS_(n) &UCSR##n##A, &UCSR##n##B, &UCSR##n##C, &UBRR##n, &UDR##n
+#define USART_REGISTERS(n)  USART_REGISTERS_(n)
+#define USART_VECTORS_(n)   ISR(USART##n##_UDRE_vect) { UsartUdre(usartPorts[n]); } \
+                            ISR(USART##n##_RX_vect) { UsartRx(usartPorts[n]); }
+#define USART_VECTORS(n)    USART_VECTORS_(n)
+
+USART_VECTORS(0)
+#if DATA_CHANNEL
+USART_VECTORS(DATA_CHANNEL)
+#endif
+#if DATA_CHANNEL_STRIPE
+USART_VECTORS(DATA_CHANNEL_STRIPE)
+#endif
+
+// 8N1, U2X divisor rounded as by the Arduino core
+static void UsartBegin(UsartPort& port, volatile BYTE* ucsra, volatile BYTE* ucsrb, volatile BYTE* ucsrc, volatile WORD* ubrr, volatile BYTE* udr,
+                       DWORD baudRate, BYTE* txRing, WORD txSize, BYTE* rxRing, WORD rxSize)
+{
+  memset(&port, 0, sizeof(UsartPort));
+  port.Ucsra = ucsra;
+  port.Ucsrb = ucsrb;
+  port.Ubrr = ubrr;
+  port.Udr = udr;
+  port.TxRing = txRing;
+  port.TxSize = txSize;
+  port.RxRing = rxRing;
+  port.RxSize = rxSize;
+  
+  *ucsra = _BV(U2X0);
+  *ubrr = (F_CPU / 4 / baudRate - 1) / 2;
+  *ucsrc = _BV(UCSZ01) | _BV(UCSZ00);
+  *ucsrb = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+}
+
 // singleton
 Ui::Ui()
 {
   m_printDisabled = false;
   m_printLength = 0;
-
-  // using a conservative value of 115 200 bps here (about 8K/s during XMODEM transfers)
-  Serial.begin(115200);
+  m_txBytes = 0;
+  m_txMillis = 0;
+  m_txStallMillis = 0;
+  m_txStallMicros = 0;
   
-  // values above this baud rate need to be conformant to the table at https://wormfood.net/avrbaudcalc.php
-  // (fOSC = 16 MHz; U2xn = 1; while at error < 2 %)
+  // SERIAL_BAUD_RATE on the console, DATA_BAUD_RATE on the data channel(s):
+  // 115 200 bps is the conservative default (about 8K/s during XMODEM transfers), with a 2.1% error at 16 MHz;
+  // 500 000, 1 000 000 and 2 000 000 bps are exact (see the table at https://wormfood.net/avrbaudcalc.php)
   //
   // even though the CH340 on my Mega2560 board does not natively support a 500000bps rate,
   // (https://www.insidegadgets.com/wp-content/uploads/2016/12/ch340g-datasheet.pdf),
   // it is tested out to be working, and still "safe" enough for data transfers (~16K/s XMODEM-1K)
   // - although this requires a terminal app (such as TeraTerm) not "tied" to classic baud rates.
-  // >=1 Mbps transfers would need a redesign of the XMODEM callback functions, or saving to an SD card, etc.
+  // 1 and 2 Mbps: a byte every 160 or 80 cycles, so the interrupt driven rings, the table driven XMODEM CRC, and XON/XOFF
+  // (SERIAL_XON_XOFF) for when XMODEM receive falls behind; streaming (XMODEM-G) to keep the line busy while reading an image
+#if DATA_CHANNEL
+  UsartBegin(usartPorts[PORT_CONSOLE], USART_REGISTERS(0), SERIAL_BAUD_RATE, consoleTxRing, CONSOLE_RING_SIZE, consoleRxRing, CONSOLE_RING_SIZE);
+#if DATA_CHANNEL_STRIPE
+  // striped, the pool ring is split in between the two
+  UsartBegin(usartPorts[PORT_DATA], USART_REGISTERS(DATA_CHANNEL), DATA_BAUD_RATE,
+             PoolGetTxRing(), POOL_TX_RING_SIZE / 2, dataRxRing, SERIAL_RX_RING_SIZE);
+  UsartBegin(usartPorts[PORT_STRIPE], USART_REGISTERS(DATA_CHANNEL_STRIPE), DATA_BAUD_RATE,
+             PoolGetTxRing() + POOL_TX_RING_SIZE / 2, POOL_TX_RING_SIZE / 2, stripeRxRing, CONSOLE_RING_SIZE);
+#else
+  UsartBegin(usartPorts[PORT_DATA], USART_REGISTERS(DATA_CHANNEL), DATA_BAUD_RATE,
+             PoolGetTxRing(), POOL_TX_RING_SIZE, dataRxRing, SERIAL_RX_RING_SIZE);
+#endif
+#else
+  UsartBegin(usartPorts[PORT_CONSOLE], USART_REGISTERS(0), SERIAL_BAUD_RATE, PoolGetTxRing(), POOL_TX_RING_SIZE, consoleRxRing, SERIAL_RX_RING_SIZE);
+#endif
+}
+
+// actual bits per second of a serial port
+DWORD Ui::getBaudRate(BYTE port)
+{
+  const UsartPort& usart = usartPorts[port];
+  const DWORD divisor = ((*usart.Ucsra & _BV(U2X0)) ? 8UL : 16UL) * (*usart.Ubrr + 1);
+  return F_CPU / divisor;
+}
+
+// statistics of a transfer over the data channel(s) from now on, see getTxBytes() etc.
+void Ui::txBegin()
+{
+  cli();
+  for (BYTE index = 0; index < sizeof(dataPorts); index++)
+  {
+    usartPorts[dataPorts[index]].TxSent = 0;
+  }
+  sei();
+  m_txStallMillis = 0;
+  m_txStallMicros = 0;
+  m_txMillis = millis();
+}
+
+void Ui::txWrite(const BYTE* data, WORD size, BYTE port)
+{
+  UsartPort& usart = usartPorts[port];
+  DWORD stallMicros = 0;
+  while (size)
+  {
+    cli();
+    const WORD tail = usart.TxTail;
+    sei();
+    
+    // room up to the tail (one byte kept free to tell full from empty) or up to the end of the ring
+    const WORD head = usart.TxHead;
+    WORD room = (tail > head) ? (tail - head - 1) : (usart.TxSize - head - (tail ? 0 : 1));
+    if (!room)
+    {
+      // full: the line (or an XOFF) is the bottleneck now
+      const DWORD waitStart = micros();
+      for (;;)
+      {
+        cli();
+        const bool moved = (usart.TxTail != tail);
+        sei();
+        if (moved)
+        {
+          break;
+        }
+      }
+      stallMicros += micros() - waitStart;
+      continue;
+    }
+    
+    if (room > size)
+    {
+      room = size;
+    }
+    memcpy(&usart.TxRing[head], data, room);
+    data += room;
+    size -= room;
+    
+    cli();
+    usart.TxHead = ((head + room) == usart.TxSize) ? 0 : (head + room);
+    *usart.Ucsrb |= _BV(UDRIE0);
+    sei();
+  }
+  
+  // mostly well below 1ms each: the remainder is carried over, as it would otherwise add up to nothing
+  m_txStallMicros += stallMicros;
+  m_txStallMillis += m_txStallMicros / 1000;
+  m_txStallMicros %= 1000;
+}
+
+// waits for the data channel ring(s) to drain, and finishes the statistics
+void Ui::txEnd()
+{
+  m_txBytes = 0;
+  for (BYTE index = 0; index < sizeof(dataPorts); index++)
+  {
+    const UsartPort& usart = usartPorts[dataPorts[index]];
+    for (;;)
+    {
+      cli();
+      const bool empty = (usart.TxTail == usart.TxHead);
+      sei();
+      if (empty)
+      {
+        break;
+      }
+    }
+    
+    cli();
+    m_txBytes += usart.TxSent;
+    sei();
+  }
+  
+  m_txMillis = millis() - m_txMillis;
+}
+
+// next received byte, or -1 if none
+int Ui::rxRead(BYTE port)
+{
+  UsartPort& usart = usartPorts[port];
+  cli();
+  const WORD head = usart.RxHead;
+  sei();
+  
+  const WORD tail = usart.RxTail;
+  if (head == tail)
+  {
+    return -1;
+  }
+  const BYTE data = usart.RxRing[tail];
+  const WORD next = (tail + 1 == usart.RxSize) ? 0 : (tail + 1);
+  cli();
+  usart.RxTail = next;
+  sei();
+  
+#if SERIAL_XON_XOFF
+  // resume the other side once mostly drained
+  const WORD used = (head >= next) ? (head - next) : (usart.RxSize - next + head);
+  if (usart.RxThrottled && (used <= (usart.RxSize / 8)))
+  {
+    cli();
+    usart.RxThrottled = false;
+    usart.TxPriority = XON;
+    *usart.Ucsrb |= _BV(UDRIE0);
+    sei();
+  }
+#endif
+
+  return data;
+}
+
+void Ui::setBinaryReceive(bool binary, BYTE port)
+{
+  UsartPort& usart = usartPorts[port];
+  usart.RxBinary = binary;
+  if (binary)
+  {
+    usart.TxPaused = false; // a stale XOFF would otherwise hold our ACKs back
+  }
 }
 
 // reset board
@@ -67,12 +373,13 @@ void Ui::print(const BYTE* str, ...)
   // print called with empty string ?
   if (!m_printLength)
   {
-    Serial.print((const char*)Progmem::getString(Progmem::uiNewLine));
+    const BYTE* newLine = Progmem::getString(Progmem::uiNewLine);
+    txWrite(newLine, strlen(newLine));
   }
   
   else
   {
-    Serial.write(m_printBuffer, m_printLength);
+    txWrite(m_printBuffer, m_printLength);
     m_printLength = 0; // reset print length  
   }
 }
@@ -85,7 +392,7 @@ BYTE Ui::readKey(const BYTE* allowedKeys, bool withWait)
   while(true)
   {
     // read keys through serial if UI not enabled
-    int read = Serial.read();      
+    int read = rxRead();      
     if (read == -1)
     {
       READKEY_CHECK_WAIT;
@@ -4,6 +4,11 @@
 #pragma once
 #include "config.h"
 
+// serial ports by USART number: the console, and where image transfers go (the console itself if DATA_CHANNEL is 0)
+#define PORT_CONSOLE 0
+#define PORT_DATA    DATA_CHANNEL
+#define PORT_STRIPE  DATA_CHANNEL_STRIPE
+
 // readkey with wait or without
 #define READKEY_CHECK_WAIT if (withWait) continue; else return 0;
 
@@ -27,6 +32,19 @@ public:
   void setPrintLength(WORD length) { m_printLength = length; }   
   void setPrintDisabled(bool disable) { m_printDisabled = disable; }
   void fatalError(BYTE progmemStrIndex);
+  DWORD getBaudRate(BYTE port = PORT_CONSOLE);
+  
+  // serial ports: writes return as soon as the data is queued, while the USART drains it by interrupts
+  void txWrite(const BYTE* data, WORD size, BYTE port = PORT_CONSOLE);  // blocks only while the ring is full
+  int rxRead(BYTE port = PORT_CONSOLE);                                 // -1 if nothing received
+  void setBinaryReceive(bool binary, BYTE port = PORT_DATA);            // XON/XOFF not interpreted, during XMODEM receive
+  
+  // transfer statistics of the data channel(s), between txBegin() and txEnd() (which waits for the rings to drain)
+  void txBegin();
+  void txEnd();
+  DWORD getTxBytes() { return m_txBytes; }
+  DWORD getTxMillis() { return m_txMillis; }
+  DWORD getTxStallMillis() { return m_txStallMillis; }
   
 private:  
   Ui(); 
@@ -36,4 +54,9 @@ private:
   WORD m_printLength;
   
   bool m_printDisabled;
+  
+  DWORD m_txBytes;
+  DWORD m_txMillis;
+  DWORD m_txStallMillis;
+  DWORD m_txStallMicros;   // below 1ms, not yet in the above
 };
\ No newline at end of file
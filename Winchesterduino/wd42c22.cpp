@@ -20,20 +20,88 @@
 // PORTH4       (D07): /TRK0%;  input
 
 // initial DWORD values for timeout decrementers:
-#define TIMEOUT_FILLSECT  100000UL  // max. duration of one IDscan inside fillSectorsTable(), ~60ms
 #define TIMEOUT_READY     200000UL  // disk is ready if /READY is consistently low for ~120ms during powerup test
-#define TIMEOUT_SETTLE    800000UL  // seek must be complete within half a second of last pulse sent
-#define TIMEOUT_IO       5000000UL  // any other WDC I/O timeout, up to 3 seconds
+
+// WDC command and seek deadlines in milliseconds, enforced by timer 1:
+#define TIMEOUT_FILLSECT        60  // max. duration of one IDscan inside fillSectorsTable()
+#define TIMEOUT_SETTLE         500  // seek must be complete within half a second of last pulse sent
 
 // interrupts - WDC "microcontroller interrupt" and drive "seek complete"
 volatile bool mcintFired = false;
+volatile DWORD mcintMicros = 0;
 void MCINT()
 {
-  // on falling edge, set internal flag
+  // on falling edge, set internal flag, and note when
+  mcintMicros = micros();
   mcintFired = true;
 }
 
+// timer 1 compare match: the command deadline has passed, stop counting
+volatile bool deadlineExpired = false;
+ISR(TIMER1_COMPA_vect)
+{
+  TCCR1B = 0;
+  deadlineExpired = true;
+}
+
+// timer 3 compare match A: one STEP pulse begins, the spacing to the next one as per the seek profile (timer ticks: 0.5us);
+// compare match B ends it, so that no interrupt busy waits for the pulse length
+volatile bool stepping = false;     // pulses being sent
+volatile WORD stepsLeft = 0;        // how many yet, only touched by the ISR once started
+volatile WORD stepTicks = 0;        // current spacing
+volatile WORD stepMinTicks = 0;     // ramped: the fastest spacing...
+volatile WORD stepRampSteps = 0;    // ...and how many steps it took to accelerate, the same to slow down
+volatile bool stepRamp = false;
+ISR(TIMER3_COMPA_vect)
+{
+  // compare B held off by other interrupts as well: it ends the pulse right after this one, the step goes a period later
+  if (PORTC & 0x10)
+  {
+    return;
+  }
+  
+  PORTC |= 0x10;
+  OCR3B = TCNT3 + SEEK_PULSE_US * 2; // the counter restarted from 0 at the match, later if this was held off
+  TIFR3 = _BV(OCF3B);                // a match of the previous pulse end while held off
+  
+  if (stepRamp)
+  {
+    if (stepsLeft <= stepRampSteps)
+    {
+      stepTicks += stepTicks / 7;   // inverse of the below
+    }
+    else if (stepTicks > stepMinTicks)
+    {
+      stepTicks -= stepTicks >> 3;
+      stepRampSteps++;
+    }
+  }
+  stepsLeft--;
+  
+  // the next one not before this pulse ends; and if held off past it, as soon as possible,
+  // as otherwise the counter runs on to 0xFFFF (32ms) for the next match
+  OCR3A = (stepTicks - 1 > OCR3B) ? stepTicks - 1 : OCR3B + 1;
+  if (TCNT3 >= OCR3A)
+  {
+    OCR3A = TCNT3 + 2;
+  }
+}
+
+ISR(TIMER3_COMPB_vect)
+{
+  PORTC &= 0xEF;
+  
+  // last one: the heads settle from now on, start the deadline prepared by seekStart()
+  if (!stepsLeft && stepping)
+  {
+    TCCR3B = 0;
+    stepping = false;
+    TCCR1B = _BV(WGM12) | _BV(CS12) | _BV(CS10);
+  }
+}
+
 volatile bool seekComplete = false;
+volatile DWORD seekCompleteMicros = 0;
 void SC()
 {
   // on change, invert drive /SC to SC output for the separator board, 
@@ -47,6 +115,7 @@ void SC()
   {
     PORTG |= 1;
     seekComplete = true;
+    seekCompleteMicros = micros();
   }
 }
 
@@ -59,10 +128,33 @@ WD42C22::WD42C22()
   
   cli(); 
   m_seekForward = false;
+  m_seekPending = false;
   m_physicalCylinder = 0;
+  m_recalibrateTime = 0;
+  m_seekStartMicros = 0;
+  m_lastSeekTime = 0;
+  m_lastSeekDistance = 0;
   m_physicalHead = 0;
   m_result = WDC_OK;
   m_errorMessage = 0;
+  memset(m_sectorStatus, 0, sizeof(m_sectorStatus));
+  m_sectorPeriod = 0;
+  memset(&m_rotation, 0, sizeof(RotationInfo));
+  invalidateTrackCache();
+  m_bcr = 0;
+  m_icr = 0;
+  m_reg3F = 0;
+  m_taskFileValid = 0;
+  m_busCycles = 0;
+  m_busCyclesSaved = 0;
+  memset(&m_staged, 0, sizeof(StagedCommand));
+  memset(m_commandStats, 0, sizeof(m_commandStats));
+  m_correctionCount = 0;
+  m_deferCorrection = false;
+  m_bufferEnd = 0;
+  m_commandOpcode = 0;
+  m_commandTimed = false;
+  m_commandStartMicros = 0;
   
   // AD0-7 default to inputs, Hi-Z  
   PORTA = 0;
@@ -99,6 +191,16 @@ WD42C22::WD42C22()
   DELAY_MS(51);
   resetController(); // and set initial options
   
+  // timer 1 stopped, normal port operation, interrupt on compare match A
+  TCCR1A = 0;
+  TCCR1B = 0;
+  TIMSK1 = _BV(OCIE1A);
+  
+  // timer 3 (step pulses) likewise
+  TCCR3A = 0;
+  TCCR3B = 0;
+  TIMSK3 = _BV(OCIE3A) | _BV(OCIE3B);
+  
   // /SC from drive and /MCINT from WDC
   attachInterrupt(digitalPinToInterrupt(2), SC, CHANGE);  
   attachInterrupt(digitalPinToInterrupt(3), MCINT, FALLING);
@@ -138,10 +240,247 @@ void WD42C22::resetController()
   // driveselect handled by ourselves
   adWrite(0x3F, 0x40);  
   
+  // the only time the register shadows are loaded from the WDC, from now on it's just the firmware changing them
+  m_bcr = adRead(0x37);
+  m_icr = adRead(0x3B);
+  m_reg3F = 0x40;
+  m_taskFileValid = 0;
+  
   mcintFired = false; // reset flags
   seekComplete = false;
 }
 
+// *** WDC command execution ***
+
+// the deadline is kept by timer 1 in CTC mode, clk/1024 (64us per tick, 4.19s max);
+// one at a time: either a WDC command or a seek in progress (seekStart without seekWait)
+void WD42C22::deadlineStart(WORD timeoutMs)
+{
+  deadlineArm(timeoutMs);
+  TCCR1B = _BV(WGM12) | _BV(CS12) | _BV(CS10);
+}
+
+// as above, stopped, to be started later
+void WD42C22::deadlineArm(WORD timeoutMs)
+{
+  DWORD ticks = ((DWORD)timeoutMs * 125) / 8;
+  if (ticks > 0xFFFF)
+  {
+    ticks = 0xFFFF;
+  }
+  else if (!ticks)
+  {
+    ticks = 1;
+  }
+  
+  TCCR1B = 0;
+  TCNT1 = 0;
+  OCR1A = (WORD)ticks;
+  TIFR1 = _BV(OCF1A); // clear a pending compare match
+  deadlineExpired = false;
+}
+
+// issue a command and return immediately; completion comes from the /MCINT interrupt
+void WD42C22::commandStart(BYTE command, WORD timeoutMs)
+{
+  // heads still settling: the deadline timer is shared, finish that first
+  if (m_seekPending)
+  {
+    seekWait();
+  }
+  
+  m_result = WDC_OK;
+  mcintFired = false;
+  
+  // the WDC advances the sector count and number as it goes, scan ID loads the whole ID found into the task file
+  m_taskFileValid &= (command == 0x40) ? 0x01 : 0x39;
+  m_commandOpcode = command;
+  m_commandTimed = true;
+  m_commandStartMicros = micros();
+  adWrite(0x27, command);
+  deadlineStart(timeoutMs);
+}
+
+bool WD42C22::commandPoll()
+{
+  // true if the command is no longer running: either completed, or WDC_TIMEOUT set
+  if (mcintFired)
+  {
+    TCCR1B = 0;
+    if (m_commandTimed)
+    {
+      m_commandTimed = false;
+      CommandStats& stats = m_commandStats[m_commandOpcode >> 4];
+      const DWORD elapsed = mcintMicros - m_commandStartMicros;
+      stats.Count++;
+      stats.TotalMicros += elapsed;
+      if (elapsed > stats.MaxMicros)
+      {
+        stats.MaxMicros = elapsed;
+      }
+    }
+    return true;
+  }
+  if (deadlineExpired)
+  {
+    m_result = WDC_TIMEOUT;
+    return true;
+  }
+  
+  return false;
+}
+
+void WD42C22::commandWait()
+{
+  while (!commandPoll()) {}
+  processResult();
+}
+
+// the common path of the data commands: buffer setup and task file from the descriptor, issue, wait
+// next: known command to follow, its task file is staged while this one runs (must not change until executed);
+// matched by its address, so a caller that returns without executing it must dropStagedCommand(), as another one may reuse that stack
+// CMD_CORRECT chains compute correction and the fix of the data in the buffer, the caller gets the final result
+void WD42C22::execute(const Command& command, const Command* next)
+{
+  if (m_staged.Source != &command)
+  {
+    stageCommand(command);
+  }
+  
+  prepareBuffer(command.Flags & CMD_WRITE, command.BufferOffset);
+  for (BYTE index = 0; index < 6; index++)
+  {
+    if (m_staged.Mask & (1 << index))
+    {
+      regWrite(0x21 + index, m_staged.TaskFile[index]);
+    }
+  }
+  m_staged.Source = NULL;
+  
+  // new data coming into the buffer: corrections of what was there are void
+  if (!(command.Flags & (CMD_WRITE | CMD_BUFFER_ONLY)))
+  {
+    const BYTE count = (command.Flags & CMD_COUNT) ? command.Count : 1;
+    const WORD end = command.BufferOffset + (WORD)count * command.SectorSizeBytes;
+    dropCorrections(command.BufferOffset, end);
+    if (end > m_bufferEnd)
+    {
+      m_bufferEnd = end;
+    }
+  }
+  
+  commandStart(command.Opcode);
+  if (next)
+  {
+    stageCommand(*next);
+  }
+  commandWait();
+  
+  if (!(command.Flags & CMD_CORRECT) || (m_result != WDC_DATAERROR) || (m_params.DataVerifyMode == MODE_CRC_16BIT))
+  {
+    return;
+  }
+  
+  // computeCorrection places its bytes to the last 16 bytes of the buffer;
+  // if this sector occupies them, or any sector read before it since sramDiscardBuffer() (not necessarily in buffer order), keep them aside
+  BYTE keepTail[16];
+  const bool tailUsed = m_bufferEnd > 2032;
+  if (tailUsed)
+  {
+    sramBeginBufferAccess(false, 2032);
+    sramReadBlock(keepTail, sizeof(keepTail));
+    sramFinishBufferAccess();
+  }
+  
+  computeCorrection();
+  
+  // correctable?
+  if (getLastError() == WDC_CORRECTED)
+  {
+    doCorrection(command.BufferOffset, tailUsed ? keepTail : NULL);
+  }
+  else if (tailUsed)
+  {
+    sramBeginBufferAccess(true, 2032);
+    sramWriteBlock(keepTail, sizeof(keepTail));
+    sramFinishBufferAccess();
+  }
+}
+
+void WD42C22::prepareBuffer(bool write /* false: disk to buffer */, WORD bufferOffset)
+{
+  BYTE bcr = regRead(0x37);
+  BYTE icr = regRead(0x3B);
+  
+  icr &= 0xF7;
+  regWrite(0x3B, icr);     // make sure MAC = 0 before changing DRWB    
+  if (write)
+  {
+    bcr |= 4;              // DRWB = 1
+  }
+  else
+  {
+    bcr &= 0xFB;           // DRWB = 0
+  }
+  regWrite(0x37, bcr);
+  adWrite(0x34, (BYTE)bufferOffset); // starting address of data, interleave table or correction bytes
+  adWrite(0x35, (BYTE)(bufferOffset >> 8));
+  regWrite(0x3F, 0x40);    // ECCM = 0, DDRQ = 1
+  icr |= 8;
+  regWrite(0x3B, icr);     // MAC = 1  
+  bcr |= 1;
+  regWrite(0x37, bcr);     // ADBP = 1  
+  icr &= 0xF7;
+  regWrite(0x3B, icr);     // MAC = 0
+}
+
+void WD42C22::stageCommand(const Command& command)
+{
+  m_staged.Source = &command;
+  m_staged.Mask = 0;
+  if (command.Flags & CMD_BUFFER_ONLY)
+  {
+    return;
+  }
+  
+  WORD currentCyl = m_physicalCylinder;
+  BYTE currentHead = m_physicalHead;
+  if (command.OverrideCyl)
+  {
+    currentCyl = *command.OverrideCyl;
+  }
+  if (command.OverrideHead)
+  {
+    currentHead = *command.OverrideHead;
+  }
+  
+  // SDH register
+  BYTE sdh = getSDHFromSectorSize(command.SectorSizeBytes);
+
+  // ECC = 1 into SDH  
+  if (m_params.DataVerifyMode != MODE_CRC_16BIT)
+  {
+    sdh |= 0x80;
+  }
+  sdh |= currentHead; // low 3 or 4 bits
+  
+  m_staged.TaskFile[0] = command.PloLength;      // PLO length
+  m_staged.TaskFile[1] = command.Count;          // sector count
+  m_staged.TaskFile[2] = command.SectorNo;       // (starting) sector number, or gap length
+  m_staged.TaskFile[3] = (BYTE)currentCyl;       // LSB
+  m_staged.TaskFile[4] = (BYTE)(currentCyl >> 8); // MSB
+  m_staged.TaskFile[5] = sdh;
+  m_staged.Mask = 0x3C;
+  if (command.Flags & CMD_PLO)
+  {
+    m_staged.Mask |= 1;
+  }
+  if (command.Flags & CMD_COUNT)
+  {
+    m_staged.Mask |= 2;
+  }
+}
+
 // *** read and write to individual registers of the WDC WD42C22 ***
 
 // WDC distinguishes between 2 interfaces: "host" and "local micro(controller)"
@@ -166,6 +505,7 @@ BYTE WD42C22::adRead(BYTE reg)
   const BYTE value = PINA;
   PORTL ^= 2;      // toggle /MRE high
   
+  m_busCycles++;
   return value;
 }
 
@@ -181,15 +521,63 @@ void WD42C22::adWrite(BYTE reg, BYTE value)
   PORTL ^= 4;      // toggle /MWE high
   PORTA = 0;   
   DDRA = 0;        // AD0-7 input Hi-Z
+  
+  m_busCycles++;
+}
+
+// shadowed registers: Buffer Control 0x37, Interface Control 0x3B, 0x3F and the task file 0x21-0x26
+// writes of the value already there are skipped, and reads come from what was written last (see resetController)
+// task file shadows are only write-side (reading 0x21 gives the error register), and dropped by commandStart() where the WDC changes them
+BYTE WD42C22::regRead(BYTE reg)
+{
+  m_busCyclesSaved++;
+  if (reg == 0x37)
+  {
+    return m_bcr;
+  }
+  return (reg == 0x3B) ? m_icr : m_reg3F;
+}
+
+void WD42C22::regWrite(BYTE reg, BYTE value)
+{
+  BYTE* shadow;
+  BYTE validBit = 0;
+  if (reg == 0x37)
+  {
+    shadow = &m_bcr;
+  }
+  else if (reg == 0x3B)
+  {
+    shadow = &m_icr;
+  }
+  else if (reg == 0x3F)
+  {
+    shadow = &m_reg3F;
+  }
+  else
+  {
+    shadow = &m_taskFile[reg - 0x21];
+    validBit = 1 << (reg - 0x21);
+  }
+  
+  if ((*shadow == value) && (!validBit || (m_taskFileValid & validBit)))
+  {
+    m_busCyclesSaved++;
+    return;
+  }
+  
+  adWrite(reg, value);
+  *shadow = value;
+  m_taskFileValid |= validBit;
 }
 
 void WD42C22::sramBeginBufferAccess(bool write /* false: read */, WORD startingOffset)
 {
-  BYTE bcr = adRead(0x37);                    // access Buffer Control and Interface Control registers
-  BYTE icr = adRead(0x3B); 
+  BYTE bcr = regRead(0x37);                   // Buffer Control and Interface Control registers, as last written
+  BYTE icr = regRead(0x3B); 
   
   icr &= 0xF7;
-  adWrite(0x3B, icr);                         // make sure MAC = 0 before changing DRWB
+  regWrite(0x3B, icr);                        // make sure MAC = 0 before changing DRWB
   if (write)
   {
     bcr &= 0xFB;                              // DRWB = 0 for writing into RAM
@@ -198,15 +586,15 @@ void WD42C22::sramBeginBufferAccess(bool write /* false: read */, WORD startingO
   {
     bcr |= 4;                                 // DRWB = 1, read
   }  
-  adWrite(0x37, bcr);
+  regWrite(0x37, bcr);
   
   icr |= 8;
-  adWrite(0x3B, icr);                         // MAC = 1
+  regWrite(0x3B, icr);                        // MAC = 1
   adWrite(0x34, (BYTE)startingOffset);        // starting address 0 LSB
   adWrite(0x35, (BYTE)(startingOffset >> 8)); // MSB
   
   bcr |= 1;
-  adWrite(0x37, bcr);                         // ADBP = 1
+  regWrite(0x37, bcr);                        // ADBP = 1
 }
 
 BYTE WD42C22::sramReadByteSequential()
@@ -222,57 +610,145 @@ void WD42C22::sramWriteByteSequential(BYTE value)
 
 void WD42C22::sramFinishBufferAccess()
 {
-  BYTE bcr = adRead(0x37);
-  BYTE icr = adRead(0x3B);
+  BYTE bcr = regRead(0x37);
+  BYTE icr = regRead(0x3B);
   
   icr &= 0xF7;
-  adWrite(0x3B, icr);                       // set MAC = 0 for proper controller operation
+  regWrite(0x3B, icr);                      // set MAC = 0 for proper controller operation
   bcr &= 0xFE;
-  adWrite(0x37, bcr);                       // ADBP = 0
+  regWrite(0x37, bcr);                      // ADBP = 0
 }
 
 void WD42C22::sramClearBuffer(WORD count)
 {
   sramBeginBufferAccess(true, 0);
-  for (WORD index = 0; index < count; index++)
+  sramFillBlock(0, count);
+  sramFinishBufferAccess();
+}
+
+// block transfers within a prepared buffer access:
+// the data port 0x36 is latched with ALE only once, as the WDC advances the buffer offset on each /MRE or /MWE strobe itself.
+// PORTL is outside the I/O space (lds/sts), so precompute both strobe states instead of toggling,
+// and unroll by 8 - about 9 cycles per byte, compared to ~45 cycles per byte through adRead/adWrite
+#define SRAM_READ_STROBE   PORTL = strobeLow; DELAY_CYCLES(2); *buffer++ = PINA; PORTL = strobeHigh;
+#define SRAM_WRITE_STROBE  PORTL = strobeLow; PORTA = *buffer++; DELAY_CYCLES(1); PORTL = strobeHigh;
+#define SRAM_FILL_STROBE   PORTL = strobeLow; DELAY_CYCLES(1); PORTL = strobeHigh;
+
+void WD42C22::sramReadBlock(BYTE* buffer, WORD count)
+{
+  m_busCycles += count + 1; // address latch, then a strobe per byte
+  PORTL ^= 8;      // toggle ALE high
+  PORTA = 0x36;
+  DDRA = 0xFF;     // AD0-7 output address
+  PORTL ^= 8;      // toggle ALE low
+  PORTA = 0;   
+  DDRA = 0;        // AD0-7 input Hi-Z
+  
+  const BYTE strobeHigh = PORTL;
+  const BYTE strobeLow = strobeHigh & 0xFD; // /MRE low
+  
+  for (WORD blocks = count >> 3; blocks; blocks--)
   {
-    sramWriteByteSequential(0);
+    SRAM_READ_STROBE SRAM_READ_STROBE SRAM_READ_STROBE SRAM_READ_STROBE
+    SRAM_READ_STROBE SRAM_READ_STROBE SRAM_READ_STROBE SRAM_READ_STROBE
+  }
+  for (BYTE remaining = count & 7; remaining; remaining--)
+  {
+    SRAM_READ_STROBE
   }
-  sramFinishBufferAccess();
+}
+
+void WD42C22::sramWriteBlock(const BYTE* buffer, WORD count)
+{
+  m_busCycles += count + 1; // address latch, then a strobe per byte
+  PORTL ^= 8;      // toggle ALE high
+  PORTA = 0x36;
+  DDRA = 0xFF;     // AD0-7 output address, and stays output for the data
+  PORTL ^= 8;      // toggle ALE low
+  
+  const BYTE strobeHigh = PORTL;
+  const BYTE strobeLow = strobeHigh & 0xFB; // /MWE low
+  
+  for (WORD blocks = count >> 3; blocks; blocks--)
+  {
+    SRAM_WRITE_STROBE SRAM_WRITE_STROBE SRAM_WRITE_STROBE SRAM_WRITE_STROBE
+    SRAM_WRITE_STROBE SRAM_WRITE_STROBE SRAM_WRITE_STROBE SRAM_WRITE_STROBE
+  }
+  for (BYTE remaining = count & 7; remaining; remaining--)
+  {
+    SRAM_WRITE_STROBE
+  }
+  
+  PORTA = 0;   
+  DDRA = 0;        // AD0-7 input Hi-Z
+}
+
+void WD42C22::sramFillBlock(BYTE value, WORD count)
+{
+  m_busCycles += count + 1; // address latch, then a strobe per byte
+  PORTL ^= 8;      // toggle ALE high
+  PORTA = 0x36;
+  DDRA = 0xFF;     // AD0-7 output address
+  PORTL ^= 8;      // toggle ALE low
+  PORTA = value;   // same value for all the strobes
+  
+  const BYTE strobeHigh = PORTL;
+  const BYTE strobeLow = strobeHigh & 0xFB; // /MWE low
+  
+  for (WORD blocks = count >> 3; blocks; blocks--)
+  {
+    SRAM_FILL_STROBE SRAM_FILL_STROBE SRAM_FILL_STROBE SRAM_FILL_STROBE
+    SRAM_FILL_STROBE SRAM_FILL_STROBE SRAM_FILL_STROBE SRAM_FILL_STROBE
+  }
+  for (BYTE remaining = count & 7; remaining; remaining--)
+  {
+    SRAM_FILL_STROBE
+  }
+  
+  PORTA = 0;   
+  DDRA = 0;        // AD0-7 input Hi-Z
 }
 
 bool WD42C22::testBoard()
 {
   // a simple test of both the WDC chip and its associated 2K buffer SRAM (6116)
   const WORD sizeToTest = 2048;
-  BYTE* testArray = new BYTE[sizeToTest];
-  if (!testArray)
-  {
-    ui->fatalError(Progmem::uiFeMemory);
-  }
+  BYTE expected[32];
+  BYTE chunk[32];
   
-  // write 2K of random values to our test array and to the buffer starting at offset 0
+  // write 2K of random values to the buffer starting at offset 0;
+  // not kept in RAM, the same sequence is generated again from the seed when comparing
+  const DWORD seed = random(1, 0x7FFFFFFFL); // seeded in constructor, nonzero
+  randomSeed(seed);
   sramBeginBufferAccess(true, 0);
-  for (WORD index = 0; index < sizeToTest; index++)
+  for (WORD index = 0; index < sizeToTest; index += sizeof(chunk))
   {
-    testArray[index] = (BYTE)random(0, 256);
-    sramWriteByteSequential(testArray[index]);
+    for (BYTE idx = 0; idx < sizeof(chunk); idx++)
+    {
+      chunk[idx] = (BYTE)random(0, 256);
+    }
+    sramWriteBlock(chunk, sizeof(chunk));
   }
   
-  // now setup WDC to read from its buffer
-  sramBeginBufferAccess(false, 0);    
-  for (WORD index = 0; index < sizeToTest; index++)
+  // now setup WDC to read from its buffer, and compare in chunks
+  randomSeed(seed);
+  sramBeginBufferAccess(false, 0);
+  for (WORD index = 0; index < sizeToTest; index += sizeof(chunk))
   {
+    for (BYTE idx = 0; idx < sizeof(expected); idx++)
+    {
+      expected[idx] = (BYTE)random(0, 256);
+    }
+    sramReadBlock(chunk, sizeof(chunk));
+    
     // mismatch?
-    if (testArray[index] != sramReadByteSequential())
+    if (memcmp(chunk, expected, sizeof(chunk)))
     {
-      delete[] testArray;
       return false; // WDC not present, not working properly or SRAM error
     }
   }
   
   sramClearBuffer(); // and also finish access to SRAM - important
-  delete[] testArray; 
   return true;
 }
 
@@ -320,9 +796,15 @@ bool WD42C22::isWriteFault()
 }
 
 // find cylinder 0 during board initialization
-// 1 slow seek step + wait for the head settle each singlestep
-bool WD42C22::recalibrate()
+// fast: buffered bursts towards cylinder 0 first, see recalibrateBurst()
+// then (or only, if not fast) 1 slow seek step + wait for the head settle each singlestep
+bool WD42C22::recalibrate(bool fast)
 { 
+  const DWORD timeStart = millis();
+  
+  // nothing else on the way
+  seekWait();
+  
   // make sure the drive is selected
   selectDrive();
   
@@ -334,8 +816,16 @@ bool WD42C22::recalibrate()
   if (isAtCylinder0())
   {
     m_physicalCylinder = 0; 
+    m_recalibrateTime = millis() - timeStart;
     return true;
   }
+  
+#if FAST_RECALIBRATE
+  if (fast)
+  {
+    recalibrateBurst();
+  }
+#endif
    
   // a maximum of 2048 cylinders can be configured
   WORD attempts = 2048;
@@ -380,12 +870,92 @@ bool WD42C22::recalibrate()
   }
 
   m_physicalCylinder = 0;  
+  m_recalibrateTime = millis() - timeStart;
   return true;
 }
 
-// seek to given cylinder and head, set reduced write current or write precompensation line
+// bursts of RECAL_BURST_STEPS buffered steps towards cylinder 0, each followed by a wait for seek complete and a look at /TRK0;
+// steps beyond cylinder 0 are ignored by the drive, so overshooting with the last burst is harmless
+// once there, one slow step away from it: the slow singlesteps in recalibrate() then find it for sure
+// if seek complete does not come in time, the drive is most likely recalibrating by itself (unparking) - also left to the slow way
+void WD42C22::recalibrateBurst()
+{
+  PORTC &= 0xDF; // towards 0
+  DELAY_CYCLES(1);
+  m_seekForward = false;
+  
+  BYTE bursts = (2048 / RECAL_BURST_STEPS) + 1;
+  while (!isAtCylinder0())
+  {
+    if (!bursts--)
+    {
+      return;
+    }
+    
+    seekComplete = false;
+    for (BYTE step = 0; step < RECAL_BURST_STEPS; step++)
+    {
+      // a drive that steps right away (not buffered) might get there earlier
+      if (isAtCylinder0())
+      {
+        break;
+      }
+      
+      PORTC ^= 0x10;
+      DELAY_US(SEEK_PULSE_US);
+      PORTC ^= 0x10;
+      DELAY_US(FASTSEEK_SRT_US);
+    }
+    
+    deadlineStart(TIMEOUT_SETTLE);
+    while (!seekComplete)
+    {
+      if (deadlineExpired)
+      {
+        TCCR1B = 0;
+        return;
+      }
+    }
+    TCCR1B = 0;
+  }
+  
+  PORTC |= 0x20;
+  DELAY_CYCLES(1);
+  m_seekForward = true;
+  
+  PORTC ^= 0x10;
+  DELAY_US(SEEK_PULSE_US);
+  PORTC ^= 0x10;
+  DELAY_MS(20);
+}
+
+// seek to given cylinder and head, and wait until the heads settle
 bool WD42C22::seekDrive(WORD toCylinder, BYTE toHead)
+{
+  return seekStart(toCylinder, toHead) && seekWait();
+}
+
+// select the head, start the step pulses and return; timer 3 sends them, seek complete is then signalled by the SC() interrupt
+// set reduced write current or write precompensation line
+// no WDC commands until seekWait(), the settle deadline is on timer 1
+bool WD42C22::seekStart(WORD toCylinder, BYTE toHead)
 { 
+  // still travelling somewhere else?
+  if (m_seekPending && ((toCylinder != m_physicalCylinder) || (toHead != m_physicalHead)))
+  {
+    if (!seekWait())
+    {
+      return false;
+    }
+  }
+  
+  // a seek to here still pending keeps its distance, its time comes in seekWait()
+  if (!m_seekPending)
+  {
+    m_lastSeekTime = 0;
+    m_lastSeekDistance = 0;
+  }
+  
   // make sure the drive is selected
   selectDrive();
   
@@ -418,38 +988,46 @@ bool WD42C22::seekDrive(WORD toCylinder, BYTE toHead)
       m_seekForward = forwards;
     }
     
-    // ST506 or buffered seek
-    const bool slowSeek = m_params.SlowSeek;
-    seekComplete = false;
-    while (count)
+    // spacing of the pulses, in timer 3 ticks
+    WORD ticks;
+    switch(m_params.SeekProfile)
     {
-      PORTC ^= 0x10;
-      DELAY_US(SEEK_PULSE_US);
-      PORTC ^= 0x10;
-      
-      if (slowSeek)
-      {
-        DELAY_MS(SLOWSEEK_SRT_MS);  
-      }
-      else
-      {
-        DELAY_US(FASTSEEK_SRT_US);
-      }
-      
-      count--;
+    case SEEK_PROFILE_RAMPED:
+      ticks = SLOWSEEK_SRT_MS * 2000U;
+      break;
+    case SEEK_PROFILE_BURST:
+      ticks = (SEEK_PULSE_US + BURSTSEEK_SRT_US) * 2;
+      break;
+    default:
+      ticks = m_params.SlowSeek ? SLOWSEEK_SRT_MS * 2000U : (SEEK_PULSE_US + FASTSEEK_SRT_US) * 2; // ST506 or buffered seek
+      break;
     }
-    
-    // wait until heads are settled after all seek pulses are done
-    DWORD wait = TIMEOUT_SETTLE;
-    while (!seekComplete)
+    if (ticks < (SEEK_PULSE_US + STEP_ISR_LATENCY_US) * 2) // the pulse must end before the next one is due, even if held off
     {
-      if (!--wait)
-      {
-        ui->fatalError(Progmem::uiFeSeek);
-        return false;
-      }    
+      ticks = (SEEK_PULSE_US + STEP_ISR_LATENCY_US) * 2;
     }
     
+    // heads are settled within the deadline after all seek pulses are done
+    deadlineArm(TIMEOUT_SETTLE);
+    seekComplete = false;
+    m_seekPending = true;
+    
+    stepsLeft = count;
+    stepTicks = ticks;
+    stepMinTicks = RAMPSEEK_SRT_US * 2;
+    stepRampSteps = 0;
+    stepRamp = (m_params.SeekProfile == SEEK_PROFILE_RAMPED);
+    stepping = true;
+    
+    // first pulse right away: CTC mode, clk/8
+    m_lastSeekDistance = count;
+    m_seekStartMicros = micros();
+    TCNT3 = 0;
+    OCR3A = 1;
+    OCR3B = 0xFFFF;
+    TIFR3 = _BV(OCF3A) | _BV(OCF3B);
+    TCCR3B = _BV(WGM32) | _BV(CS31);
+    
     m_physicalCylinder = toCylinder;
   }
   
@@ -482,9 +1060,46 @@ bool WD42C22::seekDrive(WORD toCylinder, BYTE toHead)
   return true;
 }
 
+bool WD42C22::seekPoll()
+{
+  // true if there is nothing to wait for in seekWait()
+  return !m_seekPending || (!stepping && (seekComplete || deadlineExpired));
+}
+
+bool WD42C22::seekWait()
+{
+  if (!m_seekPending)
+  {
+    return true;
+  }
+  
+  // wait for the last pulse, then until heads are settled
+  while (stepping) {}
+  while (!seekComplete)
+  {
+    if (deadlineExpired)
+    {
+      m_seekPending = false;
+      ui->fatalError(Progmem::uiFeSeek);
+      return false;
+    }
+  }
+  
+  TCCR1B = 0;
+  m_seekPending = false;
+  
+  // time taken, as timestamped by SC()
+  cli();
+  m_lastSeekTime = seekCompleteMicros - m_seekStartMicros;
+  sei();
+  return true;
+}
+
 bool WD42C22::applyParams()
 {
   // if drive parameters changed, some need to be updated to the WDC
+  // and whatever was seen on the tracks might not be valid anymore
+  invalidateTrackCache();
   loadParameterBlock(m_params.UseRLL ? 0x33 : 0x4E, 0); // gaps contain byte 0x4E if MFM, 0x33 if RLL; paddings contain zeros
   if (getLastError() == WDC_TIMEOUT)
   {
@@ -552,21 +1167,8 @@ void WD42C22::setParameter()
     command |= 4; // E=1  
   }
   
-  m_result = WDC_OK;
-  DWORD wait = TIMEOUT_IO;
-  mcintFired = false;
-  adWrite(0x27, command);
-  
-  while (!mcintFired)
-  {
-    if (!--wait)
-    {
-      m_result = WDC_TIMEOUT;
-      break;
-    }
-  }
-  
-  processResult();
+  commandStart(command);
+  commandWait();
 }
 
 void WD42C22::loadParameterBlock(BYTE dataFillGaps, BYTE dataFillPads, bool useNonStandardSizes, WORD nonStandardSize)
@@ -584,31 +1186,18 @@ void WD42C22::loadParameterBlock(BYTE dataFillGaps, BYTE dataFillPads, bool useN
   }
   
   // other registers that need to be set before issuing command
-  adWrite(0x22, dataFillGaps); // sector count register contains data byte that will be filled into GAPs during format
-  adWrite(0x23, dataFillPads); // sector number register contains data byte that will be filled into ID and DATA pads during format and write
+  regWrite(0x22, dataFillGaps); // sector count register contains data byte that will be filled into GAPs during format
+  regWrite(0x23, dataFillPads); // sector number register contains data byte that will be filled into ID and DATA pads during format and write
   
   // cylinder number will contain non-standard sector size or writeID offset LSB and MSB
   if (useNonStandardSizes)
   {
-    adWrite(0x24, (BYTE)nonStandardSize);
-    adWrite(0x25, (BYTE)(nonStandardSize >> 8));
+    regWrite(0x24, (BYTE)nonStandardSize);
+    regWrite(0x25, (BYTE)(nonStandardSize >> 8));
   }
     
-  m_result = WDC_OK;
-  DWORD wait = TIMEOUT_IO;
-  mcintFired = false;
-  adWrite(0x27, command);
-  
-  while (!mcintFired)
-  {
-    if (!--wait)
-    {
-      m_result = WDC_TIMEOUT;
-      break;
-    }
-  }
-  
-  processResult();
+  commandStart(command);
+  commandWait();
 }
 
 void WD42C22::processResult()
@@ -675,21 +1264,8 @@ void WD42C22::scanID(WORD& cylinderNo, BYTE& sectorNo, BYTE& sdh)
   // leave only sector size and head number bits (3 or 4, as set in setParameter) 
   const BYTE cancelSdh = (m_params.Heads > 8) ? 0x6F : 0x67;
   
-  m_result = WDC_OK;
-  DWORD wait = TIMEOUT_IO;
-  mcintFired = false;
-  adWrite(0x27, 0x40); // WD "scan ID" of whatever's flying thru the drive head at current cylinder
-  
-  while (!mcintFired)
-  {
-    if (!--wait)
-    {
-      m_result = WDC_TIMEOUT;
-      break;
-    }
-  }
-  
-  processResult();
+  commandStart(0x40); // WD "scan ID" of whatever's flying thru the drive head at current cylinder
+  commandWait();
   if (!getLastError())
   {
     cylinderNo = (((WORD)adRead(0x25)) << 8) | adRead(0x24);
@@ -704,137 +1280,461 @@ void WD42C22::scanID(WORD& cylinderNo, BYTE& sectorNo, BYTE& sdh)
   }
 }
 
-DWORD* WD42C22::fillSectorsTable(WORD& tableCount)
+DWORD* WD42C22::fillSectorsTable(WORD& tableCount, DWORD* table)
 {
-  // similar to above, fill a table of sector IDs
+  // similar to above, fill a table of sector IDs, until the first one passes the head again (one revolution)
   // always returns the table on success or error - no checking, needs to be quick
-  // deallocation handled by caller
+  // table storage from the caller, POOL_TABLE_ENTRIES in size
+  // the geometry (getTrackGeometry) is worked out meanwhile, in the time between two IDs
   const BYTE cancelSdh = (m_params.Heads > 8) ? 0x6F : 0x67;
   
-  tableCount = 100; // should suffice
-  DWORD* table = new DWORD[tableCount];
-  if (!table)
-  {
-    tableCount = 0;
-    ui->fatalError(Progmem::uiFeMemory);
-    return NULL;
-  }
+  tableCount = POOL_TABLE_ENTRIES; // should suffice
   memset(table, 0xFF, tableCount*sizeof(DWORD)); // each 0xFFFFFFFF value means unfilled due to error
-  
-  WORD tableIndex = 0;  
+  memset(&m_trackGeometry, 0, sizeof(TrackGeometry));
+  
+  WORD tableIndex = 0;
+  WORD revolution = 0;        // number of IDs in one, if seen whole
+  BYTE startSector = 0;       // lowest logical sector number so far...
+  BYTE maxSector = 0;         // ...highest
+  WORD startIndex = 0;        // and where in the table
+  WORD nextIndex = (WORD)-1;  // where is startSector+1, if seen
+  BYTE flags = 0;
+  DWORD firstIdMicros = 0;
+  DWORD lastIdMicros = 0;
   while (tableIndex < tableCount)
   {
-    DWORD wait = TIMEOUT_FILLSECT;
-    mcintFired = false;
-    adWrite(0x27, 0x40);
+    commandStart(0x40, TIMEOUT_FILLSECT);
+    while (!commandPoll()) {}
     
-    while (!mcintFired)
+    if (m_result == WDC_TIMEOUT)
     {
-      if (!--wait)
-      {
-        return table;
-      }
+      m_result = WDC_OK; // no need to halt here, just return what we have
+      break;
     }
     
     // AC (aborted command) == 0
-    if ((adRead(0x21) & 4) == 0)
+    if ((adRead(0x21) & 4) != 0)
+    {
+      break;
+    }
+    
+    // each entry lo-WORD: cylinder number, hi-WORD: (MSB: SDH, LSB: sector number)
+    const DWORD entry = (((((DWORD)adRead(0x26) & cancelSdh) << 24) | (DWORD)adRead(0x23) << 16)) | ((((WORD)adRead(0x25)) << 8) | adRead(0x24));
+    lastIdMicros = mcintMicros;
+    
+    // the first ID again, done
+    if (tableIndex && (entry == table[0]))
     {
-      // each entry lo-WORD: cylinder number, hi-WORD: (MSB: SDH, LSB: sector number)
-      table[tableIndex++] = (((((DWORD)adRead(0x26) & cancelSdh) << 24) | (DWORD)adRead(0x23) << 16)) | ((((WORD)adRead(0x25)) << 8) | adRead(0x24));
+      revolution = tableIndex;
+      break;
+    }
+    
+    table[tableIndex] = entry;
+    const BYTE sector = (BYTE)(entry >> 16);
+    const BYTE sdh = (BYTE)(entry >> 24);
+    
+    if (!tableIndex)
+    {
+      firstIdMicros = lastIdMicros;
+      startSector = sector;
+      maxSector = sector;
     }
     else
     {
-      return table;
+      // a new lowest sector: its successor is either the previous lowest one, or not seen yet
+      if (sector < startSector)
+      {
+        nextIndex = (sector+1 == startSector) ? startIndex : (WORD)-1;
+        startSector = sector;
+        startIndex = tableIndex;
+      }
+      else if (sector == startSector+1)
+      {
+        nextIndex = tableIndex;
+      }
+      
+      if (sector > maxSector)
+      {
+        maxSector = sector;
+      }
+      if ((sdh & 0x9F) != (((BYTE)(table[0] >> 24)) & 0x9F))
+      {
+        flags |= TRACK_VARIABLE_SIZE;
+      }
+    }
+    
+    if ((WORD)entry != m_physicalCylinder) // loword: cylinder number
+    {
+      flags |= TRACK_CYLINDER_MISMATCH;
+    }
+#if defined(WDC_FORCE_3BIT_SDH) && (WDC_FORCE_3BIT_SDH == 1)
+    if ((m_physicalHead & 7) != (sdh & 7))
+#else
+    if (m_physicalHead != (sdh & 0xF))
+#endif
+    {
+      flags |= TRACK_HEAD_MISMATCH;
+    }
+    
+    tableIndex++;
+  }
+  
+  // the IDs were caught one after another, so this gives the time between two sectors passing the head
+  // (with the first ID seen again, the last interval closes the revolution)
+  if (revolution)
+  {
+    m_sectorPeriod = (lastIdMicros - firstIdMicros) / revolution;
+  }
+  else if (tableIndex > 1)
+  {
+    m_sectorPeriod = (lastIdMicros - firstIdMicros) / (tableIndex - 1);
+  }
+  
+  if (!tableIndex)
+  {
+    return table;
+  }
+  
+  // not a whole revolution, or not all sector numbers between the lowest and highest one seen
+  const bool wholeRevolution = (revolution != 0);
+  if (!wholeRevolution)
+  {
+    revolution = tableIndex;
+    flags |= TRACK_ID_GAPS;
+  }
+  if ((WORD)(maxSector - startSector + 1) != revolution)
+  {
+    flags |= TRACK_ID_GAPS;
+  }
+  
+  m_trackGeometry.SectorsPerTrack = (revolution < 127) ? revolution : 127;
+  m_trackGeometry.StartSector = startSector;
+  m_trackGeometry.Flags = flags;
+  
+  // physical distance between the lowest sector and its successor
+  if (revolution < 3)
+  {
+    m_trackGeometry.Interleave = 1;
+  }
+  else if (nextIndex != (WORD)-1)
+  {
+    const WORD interleave = (nextIndex + revolution - startIndex) % revolution;
+    m_trackGeometry.Interleave = (interleave < 32) ? interleave : 0;
+  }
+  
+  // repeat the revolution in the rest of the table, the users of it look past the lowest sector number
+  if (wholeRevolution)
+  {
+    tableCount = (revolution*2 < tableCount) ? revolution*2 : tableCount;
+    for (WORD index = tableIndex; index < tableCount; index++)
+    {
+      table[index] = table[index - revolution];
     }
   }
   
   return table;
 }
 
-void WD42C22::readSector(BYTE sectorNo, WORD sectorSizeBytes, bool longMode, WORD* overrideCyl, BYTE* overrideHead)
+// time the revolutions of the track under the head by its sector IDs passing by, one after another:
+// whenever the first ID seen comes around again, a revolution is done
+// the longest gap between two IDs is where the index and the track gap is
+bool WD42C22::measureRotation(BYTE revolutions)
+{
+  const BYTE cancelSdh = (m_params.Heads > 8) ? 0x6F : 0x67;
+  memset(&m_rotation, 0, sizeof(RotationInfo));
+  if (!revolutions)
+  {
+    return false;
+  }
+  
+  DWORD reference = 0xFFFFFFFF;
+  DWORD referenceMicros = 0;
+  DWORD lastMicros = 0;
+  DWORD periodSum = 0;
+  DWORD periodMin = 0xFFFFFFFF;
+  DWORD periodMax = 0;
+  DWORD gapPeriod = 0;
+  BYTE gapSector = 0;
+  WORD ids = 0;
+  BYTE done = 0;
+  
+  // a full table worth of IDs per revolution at most
+  DWORD attempts = (DWORD)(revolutions+1) * POOL_TABLE_ENTRIES;
+  while (done < revolutions)
+  {
+    if (!attempts--)
+    {
+      return false;
+    }
+    
+    commandStart(0x40, TIMEOUT_FILLSECT);
+    while (!commandPoll()) {}
+    
+    if (m_result == WDC_TIMEOUT)
+    {
+      m_result = WDC_OK; // unformatted, no need to halt
+      return false;
+    }
+    if ((adRead(0x21) & 4) != 0)
+    {
+      return false;
+    }
+    
+    const DWORD entry = (((((DWORD)adRead(0x26) & cancelSdh) << 24) | (DWORD)adRead(0x23) << 16)) | ((((WORD)adRead(0x25)) << 8) | adRead(0x24));
+    const DWORD now = mcintMicros;
+    if (reference == 0xFFFFFFFF)
+    {
+      reference = entry;
+      referenceMicros = now;
+      lastMicros = now;
+      continue;
+    }
+    
+    const DWORD interval = now - lastMicros;
+    lastMicros = now;
+    if (!done)
+    {
+      ids++;
+      if (interval > gapPeriod)
+      {
+        gapPeriod = interval;
+        gapSector = (BYTE)(entry >> 16);
+      }
+    }
+    
+    if (entry == reference)
+    {
+      const DWORD period = now - referenceMicros;
+      referenceMicros = now;
+      periodSum += period;
+      if (period < periodMin) periodMin = period;
+      if (period > periodMax) periodMax = period;
+      done++;
+    }
+  }
+  
+  m_rotation.Period = periodSum / done;
+  m_rotation.PeriodMin = periodMin;
+  m_rotation.PeriodMax = periodMax;
+  m_rotation.SectorsPerTrack = (ids < 255) ? ids : 255;
+  m_rotation.SectorPeriod = m_rotation.Period / ids;
+  m_rotation.GapPeriod = gapPeriod;
+  m_rotation.GapSector = gapSector;
+  m_rotation.ReferenceMicros = referenceMicros;
+  m_rotation.ReferenceSector = (BYTE)(reference >> 16);
+  m_rotation.Revolutions = done;
+  m_sectorPeriod = m_rotation.SectorPeriod;
+  return true;
+}
+
+// microseconds since the reference sector ID last passed the head, as of a micros() timestamp;
+// divide by the sector period for the physical sector position after the reference ID
+// the longer after the measurement, the less accurate
+DWORD WD42C22::getRotationPhase(DWORD atMicros)
+{
+  if (!m_rotation.Period)
+  {
+    return 0;
+  }
+  
+  return (atMicros - m_rotation.ReferenceMicros) % m_rotation.Period;
+}
+
+// revolutions per minute * 100, 0 if not measured
+DWORD WD42C22::getRPM100()
+{
+  if (!m_rotation.Period)
+  {
+    return 0;
+  }
+  
+  // in two steps, 6 billion does not fit
+  return ((60000000UL / m_rotation.Period) * 100) + (((60000000UL % m_rotation.Period) * 100) / m_rotation.Period);
+}
+
+// track cache, keyed by the current physical cylinder and head
+const WD42C22::TrackInfo* WD42C22::getCachedTrack()
+{
+  for (BYTE index = 0; index < TRACK_CACHE_ENTRIES; index++)
+  {
+    const TrackInfo& entry = m_trackCache[index];
+    if (entry.Geometry.SectorsPerTrack && (entry.Cylinder == m_physicalCylinder) && (entry.Head == m_physicalHead))
+    {
+      return &entry;
+    }
+  }
+  
+  return NULL;
+}
+
+void WD42C22::cacheTrack(const TrackInfo& info)
+{
+  if (!info.Geometry.SectorsPerTrack || (info.Geometry.SectorsPerTrack > TRACK_CACHE_MAX_SPT))
+  {
+    return;
+  }
+  
+  // replace the same track, or the oldest entry
+  invalidateCachedTrack();
+  TrackInfo& entry = m_trackCache[m_trackCacheNext];
+  m_trackCacheNext = (m_trackCacheNext + 1) % TRACK_CACHE_ENTRIES;
+  
+  entry = info;
+  entry.Cylinder = m_physicalCylinder;
+  entry.Head = m_physicalHead;
+}
+
+void WD42C22::invalidateCachedTrack()
+{
+  for (BYTE index = 0; index < TRACK_CACHE_ENTRIES; index++)
+  {
+    TrackInfo& entry = m_trackCache[index];
+    if ((entry.Cylinder == m_physicalCylinder) && (entry.Head == m_physicalHead))
+    {
+      entry.Geometry.SectorsPerTrack = 0;
+    }
+  }
+}
+
+void WD42C22::invalidateTrackCache()
+{
+  memset(m_trackCache, 0, sizeof(m_trackCache));
+  m_trackCacheNext = 0;
+}
+
+void WD42C22::readSector(BYTE sectorNo, WORD sectorSizeBytes, bool longMode, WORD* overrideCyl, BYTE* overrideHead, WORD bufferOffset)
 {
   // read sector of the current track and head into the buffer
   // sectorSizeBytes: 128, 256, 512, 1024 currently
   // longMode: do not check ECC/CRC; instead, append the 4 or 7 checksum bytes into the buffer
   // overrideCyl, overrideHead: logical sector information differs from the physical cylinder and head
-   
-  BYTE bcr = adRead(0x37);
-  BYTE icr = adRead(0x3B);
-  
-  icr &= 0xF7;
-  adWrite(0x3B, icr);      // make sure MAC = 0 before changing DRWB    
-  bcr &= 0xFB;             // DRWB = 0
-  adWrite(0x37, bcr);
-  adWrite(0x34, 0);        // starting address of data into the buffer
-  adWrite(0x35, 0);
-  adWrite(0x3F, 0x40);     // ECCM = 0, DDRQ = 1
-  icr |= 8;
-  adWrite(0x3B, icr);      // MAC = 1  
-  bcr |= 1;
-  adWrite(0x37, bcr);      // ADBP = 1  
-  icr &= 0xF7;
-  adWrite(0x3B, icr);      // MAC = 0
+  // bufferOffset: where to place the data in SRAM, 0 unless called from readSectors
+  
+  Command command = {};
+  command.Opcode = longMode ? 0x22 : 0x20; // read, L=1
+  command.Flags = CMD_CORRECT;
+  command.SectorNo = sectorNo;
+  command.SectorSizeBytes = sectorSizeBytes;
+  command.BufferOffset = bufferOffset;
+  command.OverrideCyl = overrideCyl;
+  command.OverrideHead = overrideHead;
+  execute(command);
+}
+
+BYTE WD42C22::readSectors(BYTE startSector, BYTE count, WORD sectorSizeBytes, WORD* overrideCyl, BYTE* overrideHead, BYTE firstIndex)
+{
+  // read count of logically consecutive sectors with the read multisector command, up to the whole 2K buffer,
+  // each sector N of the run placed at buffer offset N*sectorSizeBytes
+  // the command stops at the first sector in error: that one is then re-read alone by readSector (with ECC correction),
+  // and the burst continues from the next one
+  // firstIndex: the run is read from this sector to its end first, then from its beginning - zero latency if that one is coming under the head;
+  // the last slot can then be in the buffer before a sector of the wrap around run needs its correction computed, which overwrites
+  // the last 16 bytes of SRAM: execute() keeps them, as the whole run counts as one window since sramDiscardBuffer() here
+  // per-sector result in getSectorStatus(); returns how many were processed, less than count only on WDC_TIMEOUT, not ready, or writefault
   
-  WORD currentCyl = m_physicalCylinder;
-  BYTE currentHead = m_physicalHead;
-  if (overrideCyl)
+  const BYTE maxCount = (BYTE)(2048 / sectorSizeBytes);
+  if (count > maxCount)
   {
-    currentCyl = *overrideCyl;
+    count = maxCount;
   }
-  if (overrideHead)
+  if (firstIndex >= count)
   {
-    currentHead = *overrideHead;
+    firstIndex = 0;
   }
+  sramDiscardBuffer();
   
-  // prepare task file registers  
-  adWrite(0x23, sectorNo);                // sector number
-  adWrite(0x24, (BYTE)currentCyl);        // LSB
-  adWrite(0x25, (BYTE)(currentCyl >> 8)); // MSB
+  BYTE firstError = WDC_OK;
+  BYTE firstErrorMessage = Progmem::uiEmpty;
+  BYTE processed = 0;
+  BYTE from = firstIndex;
+  BYTE to = count;
   
-  // prepare SDH register
-  BYTE sdh = getSDHFromSectorSize(sectorSizeBytes);
-
-  // ECC = 1 into SDH  
-  if (m_params.DataVerifyMode != MODE_CRC_16BIT)
-  {
-    sdh |= 0x80;
-  }
-  sdh |= currentHead; // low 3 or 4 bits
-  adWrite(0x26, sdh);
+  Command burst = {};
+  burst.Opcode = 0x24; // read multisector
+  burst.Flags = CMD_COUNT;
+  burst.SectorSizeBytes = sectorSizeBytes;
+  burst.OverrideCyl = overrideCyl;
+  burst.OverrideHead = overrideHead;
   
-  BYTE command = 0x20; // read
-  if (longMode)
-  {
-    command |= 2;      // L=1
-  }
-
-  m_result = WDC_OK;
-  DWORD wait = TIMEOUT_IO;
-  mcintFired = false;
-  adWrite(0x27, command);
+  // the run from its beginning after the wrap around, staged while the bursts before it run
+  Command wrap = burst;
+  wrap.SectorNo = startSector;
+  wrap.Count = firstIndex;
   
-  while (!mcintFired)
+  for (;;)
   {
-    if (!--wait)
+    BYTE index = from;
+    while (index < to)
     {
-      m_result = WDC_TIMEOUT;
-      break;
+      if (firstIndex && !from && !index) // the whole wrap around run, as staged
+      {
+        execute(wrap);
+      }
+      else
+      {
+        burst.SectorNo = startSector + index;
+        burst.Count = to - index;
+        burst.BufferOffset = index * sectorSizeBytes;
+        execute(burst, from ? &wrap : NULL);
+      }
+      
+      if (!m_result)
+      {
+        while (index < to)
+        {
+          m_sectorStatus[index++] = WDC_OK;
+          processed++;
+        }
+        break;
+      }
+      
+      if (m_result < WDC_NOADDRMARK) // timeout, not ready, writefault
+      {
+        dropStagedCommand();
+        return processed;
+      }
+      
+      // sector number register stopped at the offending sector, everything before it is in the buffer
+      BYTE failed = adRead(0x23) - startSector;
+      if ((failed < index) || (failed >= to))
+      {
+        failed = index;
+      }
+      while (index < failed)
+      {
+        m_sectorStatus[index++] = WDC_OK;
+        processed++;
+      }
+      
+      readSector(startSector + failed, sectorSizeBytes, false, overrideCyl, overrideHead, failed * sectorSizeBytes);
+      if (m_result && (m_result < WDC_NOADDRMARK))
+      {
+        dropStagedCommand();
+        return processed;
+      }
+      
+      m_sectorStatus[index++] = m_result;
+      processed++;
+      if (m_result && !firstError)
+      {
+        firstError = m_result;
+        firstErrorMessage = m_errorMessage;
+      }
     }
-  }
-  
-  processResult();
-  
-  // try to correct ECC error
-  if ((getLastError() == WDC_DATAERROR) && (m_params.DataVerifyMode != MODE_CRC_16BIT))
-  {
-    computeCorrection();
     
-    // correctable?
-    if (getLastError() == WDC_CORRECTED)
+    // wrap around to the beginning of the run
+    if (!from)
     {
-      doCorrection();
+      break;
     }
+    to = from;
+    from = 0;
   }
+  
+  // getLastError reflects the first sector that did not read cleanly
+  m_result = firstError;
+  m_errorMessage = firstErrorMessage;
+  return count;
 }
 
 void WD42C22::verifyTrack(BYTE sectorsPerTrack, WORD sectorSizeBytes, BYTE startSector, WORD* overrideCyl, BYTE* overrideHead)
@@ -843,105 +1743,57 @@ void WD42C22::verifyTrack(BYTE sectorsPerTrack, WORD sectorSizeBytes, BYTE start
   // the SRAM buffer is too small for whole track reads, and its contents are trashed
   // used for quick verify during mainmenu format:
   // if this fails, fall back to individual readSector to determine offending sectors
+  // zero latency: instead of waiting for startSector, begin with a sector coming up under the head and wrap around
   
-  BYTE bcr = adRead(0x37);
-  BYTE icr = adRead(0x3B);
-  
-  icr &= 0xF7;
-  adWrite(0x3B, icr);      // make sure MAC = 0 before changing DRWB    
-  bcr &= 0xFB;             // DRWB = 0
-  adWrite(0x37, bcr);
-  adWrite(0x34, 0);        // starting address of data into the buffer
-  adWrite(0x35, 0);
-  adWrite(0x3F, 0x40);     // ECCM = 0, DDRQ = 1
-  icr |= 8;
-  adWrite(0x3B, icr);      // MAC = 1  
-  bcr |= 1;
-  adWrite(0x37, bcr);      // ADBP = 1  
-  icr &= 0xF7;
-  adWrite(0x3B, icr);      // MAC = 0
-  
-  WORD currentCyl = m_physicalCylinder;
-  BYTE currentHead = m_physicalHead;
-  if (overrideCyl)
+  BYTE first = startSector;
+  WORD cylinder;
+  BYTE sector;
+  BYTE sdh;
+  scanID(cylinder, sector, sdh);
+  if (m_result && (m_result < WDC_NOADDRMARK))
   {
-    currentCyl = *overrideCyl;
+    return;
   }
-  if (overrideHead)
+  if (!m_result && (sectorsPerTrack > 2) && (sector >= startSector) && (sector - startSector < sectorsPerTrack))
   {
-    currentHead = *overrideHead;
+    // the one right after the ID just seen passes by while the command is being issued, unless interleaved
+    first = startSector + ((sector - startSector + 2) % sectorsPerTrack);
   }
   
-  // prepare task file registers  
-  adWrite(0x22, sectorsPerTrack);         // sector count
-  adWrite(0x23, startSector);             // starting sector number
-  adWrite(0x24, (BYTE)currentCyl);        // LSB
-  adWrite(0x25, (BYTE)(currentCyl >> 8)); // MSB
+  Command run = {};
+  run.Opcode = 0x24; // read multisector
+  run.Flags = CMD_COUNT;
+  run.SectorNo = first;
+  run.Count = (BYTE)(startSector + sectorsPerTrack - first);
+  run.SectorSizeBytes = sectorSizeBytes;
+  run.OverrideCyl = overrideCyl;
+  run.OverrideHead = overrideHead;
   
-  // prepare SDH register
-  BYTE sdh = getSDHFromSectorSize(sectorSizeBytes);
-
-  // ECC = 1 into SDH  
-  if (m_params.DataVerifyMode != MODE_CRC_16BIT)
+  // the rest from the beginning
+  Command wrap = run;
+  wrap.SectorNo = startSector;
+  wrap.Count = sectorsPerTrack - run.Count;
+  
+  const bool wrapped = (first != startSector);
+  execute(run, wrapped ? &wrap : NULL);
+  if (!m_result && wrapped)
   {
-    sdh |= 0x80;
+    execute(wrap);
   }
-  sdh |= currentHead; // low 3 or 4 bits
-  adWrite(0x26, sdh);
-  
-  m_result = WDC_OK;
-  DWORD wait = TIMEOUT_IO;
-  mcintFired = false;
-  adWrite(0x27, 0x24); // read multisector
-  
-  while (!mcintFired)
+  else
   {
-    if (!--wait)
-    {
-      m_result = WDC_TIMEOUT;
-      break;
-    }
+    dropStagedCommand(); // error: the caller falls back to single sectors
   }
-  
-  processResult();  
 }
 
 void WD42C22::computeCorrection()
 {
   // only valid for ECC modes
-  
-  BYTE bcr = adRead(0x37);
-  BYTE icr = adRead(0x3B);
-  
-  icr &= 0xF7;
-  adWrite(0x3B, icr);      // make sure MAC = 0 before changing DRWB    
-  bcr &= 0xFB;             // DRWB = 0
-  adWrite(0x37, bcr);
-  adWrite(0x34, 0xF0);     // starting address of error correction bytes: offset 2032 
-  adWrite(0x35, 7);        // (max 1K sectors supported atm)
-  adWrite(0x3F, 0x40);     // ECCM = 0, DDRQ = 1
-  icr |= 8;
-  adWrite(0x3B, icr);      // MAC = 1  
-  bcr |= 1;
-  adWrite(0x37, bcr);      // ADBP = 1  
-  icr &= 0xF7;
-  adWrite(0x3B, icr);      // MAC = 0
-  
-  m_result = WDC_OK;
-  DWORD wait = TIMEOUT_IO;
-  mcintFired = false;
-  adWrite(0x27, 8);        // compute correction
-  
-  while (!mcintFired)
-  {
-    if (!--wait)
-    {
-      m_result = WDC_TIMEOUT;
-      break;
-    }
-  }
-  
-  processResult();         // if still WDC_DATAERROR, it is an uncorrectable error and the computed data are not helpful
+  Command correction = {};
+  correction.Opcode = 8;                // compute correction
+  correction.Flags = CMD_BUFFER_ONLY;
+  correction.BufferOffset = 2032;       // starting address of error correction bytes: last 16 bytes (max 1K sectors supported atm)
+  execute(correction);                  // if still WDC_DATAERROR, it is an uncorrectable error and the computed data are not helpful
   if (m_result != WDC_DATAERROR)
   {
     m_result = WDC_CORRECTED;
@@ -949,19 +1801,25 @@ void WD42C22::computeCorrection()
   }
 }
 
-void WD42C22::doCorrection()
+void WD42C22::doCorrection(WORD bufferOffset, const BYTE* keepTail)
 {
   // max 7 syndrome bytes (unused here) + 2 byte offset + max 7 error pattern bytes
   BYTE data[16] = {0};
   
   // retrieve error correction bytes from SRAM buffer offset 2032 (last 16 bytes)
   sramBeginBufferAccess(false, 2032);
-  for (BYTE index = 0; index < 16; index++)
+  sramReadBlock(data, 16);
+  
+  // sector data that was there before, put it back
+  if (keepTail)
   {
-    data[index] = sramReadByteSequential();
+    sramBeginBufferAccess(true, 2032);
+    sramWriteBlock(keepTail, 16);
   }
   
-  const WORD errorLocation = ((WORD)(data[7]) << 8) | data[8]; // after syndrome bytes
+  // error offset is relative to the start of the sector data field
+  const WORD sectorOffset = ((WORD)(data[7]) << 8) | data[8]; // after syndrome bytes
+  const WORD errorLocation = bufferOffset + sectorOffset;
   const BYTE eccSize = (m_params.DataVerifyMode == MODE_ECC_56BIT) ? 7 : 4;
   
   // 4 byte ECC: default correction span of 5 bits, XOR first two error pattern bytes
@@ -970,26 +1828,79 @@ void WD42C22::doCorrection()
   {
     spanningCorrection ^= data[11];
   }
+  data[9] ^= spanningCorrection;
+  
+  // keep it, one per sector in the buffer
+  Correction* correction = NULL;
+  if (m_correctionCount < CORRECTION_ENTRIES)
+  {
+    correction = &m_corrections[m_correctionCount++];
+    correction->Offset = errorLocation;
+    correction->SectorOffset = sectorOffset;
+    correction->Length = eccSize;
+    correction->Pending = m_deferCorrection;
+    memcpy(correction->Pattern, &data[9], eccSize);
+  }
+  
+  // deferred: applied when the sector is read out of SRAM, no more buffer passes now
+  if (correction && correction->Pending)
+  {
+    sramFinishBufferAccess();
+    return;
+  }
   
   // read faulty disk data, correct it with the error pattern, and place corrected data into the (unused) syndrome bytes
   sramBeginBufferAccess(false, errorLocation);
+  sramReadBlock(data, eccSize);
   for (BYTE index = 0; index < eccSize; index++)
   {
-    data[index] = sramReadByteSequential() ^ data[index+9];
+    data[index] ^= data[index+9];
   }  
-  data[0] ^= spanningCorrection;
   
   // we can only read or only write the SRAM buffer, and that in a single direction, so now write the corrected data back
   sramBeginBufferAccess(true, errorLocation);
-  for (BYTE index = 0; index < eccSize; index++)
-  {
-    sramWriteByteSequential(data[index]);
-  }
+  sramWriteBlock(data, eccSize);
   
   // done
   sramFinishBufferAccess();
 }
 
+void WD42C22::dropCorrections(WORD from, WORD to)
+{
+  BYTE kept = 0;
+  for (BYTE index = 0; index < m_correctionCount; index++)
+  {
+    const Correction& correction = m_corrections[index];
+    if ((correction.Offset + correction.Length <= from) || (correction.Offset >= to))
+    {
+      m_corrections[kept++] = correction;
+    }
+  }
+  m_correctionCount = kept;
+}
+
+void WD42C22::applyCorrections(BYTE* data, WORD bufferOffset, WORD count)
+{
+  // data: count bytes just read out of SRAM, starting at bufferOffset; pending corrections in that range are XORed in
+  for (BYTE index = 0; index < m_correctionCount; index++)
+  {
+    const Correction& correction = m_corrections[index];
+    if (!correction.Pending)
+    {
+      continue;
+    }
+    
+    for (BYTE patternIdx = 0; patternIdx < correction.Length; patternIdx++)
+    {
+      const WORD position = correction.Offset + patternIdx;
+      if ((position >= bufferOffset) && (position < bufferOffset + count))
+      {
+        data[position - bufferOffset] ^= correction.Pattern[patternIdx];
+      }
+    }
+  }
+}
+
 WORD WD42C22::getSectorSizeFromSDH(BYTE sdh)
 { 
   sdh &= 0x60;
@@ -1027,7 +1938,7 @@ BYTE WD42C22::getSDHFromSectorSize(WORD sectorSizeBytes)
   return sdh;
 }
 
-bool WD42C22::prepareFormatInterleave(BYTE sectorsPerTrack, BYTE interleave, BYTE startSector, BYTE* badBlocksTable)
+bool WD42C22::prepareFormatInterleave(BYTE sectorsPerTrack, BYTE interleave, BYTE startSector, BYTE* badBlocksTable, BYTE skew)
 {
   // writes a special interleave table for the WDC into its buffer
   // 2 bytes per each sector, structure:
@@ -1039,19 +1950,15 @@ bool WD42C22::prepareFormatInterleave(BYTE sectorsPerTrack, BYTE interleave, BYT
   // badBlocksTable: if not null, points to an array of bytes, sectorsPerTrack size
   // array index is physical sector index, not its interleaved value
   // e.g. badBlocksTable[0] nonzero, [1] zero: first sector on track is marked bad, second is good
+  // skew: rotates the whole logical sequence by this many physical sectors after the index (track and head skew)
   
   BYTE* interleaveTable = NULL; // fallback to sequential on invalid values
   if ((interleave > 1) && (interleave < sectorsPerTrack))
   {
-    interleaveTable = new BYTE[sectorsPerTrack + 1];
-    if (!interleaveTable)
-    {
-      ui->fatalError(Progmem::uiFeMemory);
-      return false;
-    }
+    interleaveTable = PoolGetScratch(); // sectorsPerTrack+1 bytes
   }
 
-  if (interleaveTable) // not allocated on sequential sectors
+  if (interleaveTable) // not used on sequential sectors
   {
     memset(interleaveTable, 0, sectorsPerTrack+1);
     
@@ -1084,8 +1991,9 @@ bool WD42C22::prepareFormatInterleave(BYTE sectorsPerTrack, BYTE interleave, BYT
       sramWriteByteSequential(0); // mark good block
     }
     
-    // set logical sector number from prepared interleave table
-    BYTE sectorNumber = interleaveTable ? interleaveTable[sector+1] : sector+1;
+    // set logical sector number from prepared interleave table, skewed
+    const BYTE from = (sector + sectorsPerTrack - (skew % sectorsPerTrack)) % sectorsPerTrack;
+    BYTE sectorNumber = interleaveTable ? interleaveTable[from+1] : from+1;
     
     // if startSector is not 1-based, adjust this value
     if (startSector == 0)
@@ -1099,12 +2007,6 @@ bool WD42C22::prepareFormatInterleave(BYTE sectorsPerTrack, BYTE interleave, BYT
     sramWriteByteSequential(sectorNumber);
   }  
   sramFinishBufferAccess();
-  
-  if (interleaveTable)
-  {
-    delete[] interleaveTable;
-  }
-  
   return true;
 }
 
@@ -1112,6 +2014,7 @@ void WD42C22::formatTrack(BYTE sectorsPerTrack, WORD sectorSizeBytes, WORD* over
 {
   // expects the SRAM buffer already prepared with prepareFormatInterleave()  
   // overrideCyl, overrideHead: logical sector information differs from the physical cylinder and head
+  invalidateCachedTrack();
     
   // idPloLength: "length of the ID PLO sync field" - byte padding before the actual ID field starts,
   // for the Phase Locked Oscillator (in the data separator) to synchronize properly
@@ -1129,67 +2032,17 @@ void WD42C22::formatTrack(BYTE sectorsPerTrack, WORD sectorSizeBytes, WORD* over
   BYTE gapSize = sectorSizeBytes/16;
   gapSize += 8;
   
-  BYTE bcr = adRead(0x37);
-  BYTE icr = adRead(0x3B);
-  
-  icr &= 0xF7;
-  adWrite(0x3B, icr);      // make sure MAC = 0 before changing DRWB    
-  bcr |= 4;                // DRWB = 1
-  adWrite(0x37, bcr);
-  adWrite(0x34, 0);        // starting address of interleave table
-  adWrite(0x35, 0);
-  adWrite(0x3F, 0x40);     // ECCM = 0, DDRQ = 1
-  icr |= 8;
-  adWrite(0x3B, icr);      // MAC = 1  
-  bcr |= 1;
-  adWrite(0x37, bcr);      // ADBP = 1  
-  icr &= 0xF7;
-  adWrite(0x3B, icr);      // MAC = 0
-  
-  WORD currentCyl = m_physicalCylinder;
-  BYTE currentHead = m_physicalHead;
-  if (overrideCyl)
-  {
-    currentCyl = *overrideCyl;
-  }
-  if (overrideHead)
-  {
-    currentHead = *overrideHead;
-  }
-  
-  // prepare task file registers
-  adWrite(0x21, idPloLength);             // PLO length
-  adWrite(0x22, sectorsPerTrack);         // sector count
-  adWrite(0x23, gapSize-3);               // WD: Gap length written on disk is 3 bytes longer than gap value specified in sector number register
-  adWrite(0x24, (BYTE)currentCyl);        // LSB
-  adWrite(0x25, (BYTE)(currentCyl >> 8)); // MSB
-  
-  // prepare SDH register
-  BYTE sdh = getSDHFromSectorSize(sectorSizeBytes);
-
-  // ECC = 1 into SDH  
-  if (m_params.DataVerifyMode != MODE_CRC_16BIT)
-  {
-    sdh |= 0x80;
-  }
-  sdh |= currentHead; // low 3 or 4 bits
-  adWrite(0x26, sdh);
-  
-  m_result = WDC_OK;
-  DWORD wait = TIMEOUT_IO;
-  mcintFired = false;
-  adWrite(0x27, 0x51);
-  
-  while (!mcintFired)
-  {
-    if (!--wait)
-    {
-      m_result = WDC_TIMEOUT;
-      break;
-    }
-  }
-  
-  processResult();  
+  // buffer: interleave table, at its start
+  Command command = {};
+  command.Opcode = 0x51;
+  command.Flags = CMD_WRITE | CMD_COUNT | CMD_PLO;
+  command.PloLength = idPloLength;
+  command.Count = sectorsPerTrack;
+  command.SectorNo = gapSize-3;   // WD: Gap length written on disk is 3 bytes longer than gap value specified in sector number register
+  command.SectorSizeBytes = sectorSizeBytes;
+  command.OverrideCyl = overrideCyl;
+  command.OverrideHead = overrideHead;
+  execute(command);
 }
 
 void WD42C22::writeSector(BYTE sectorNo, WORD sectorSizeBytes, WORD* overrideCyl, BYTE* overrideHead)
@@ -1197,67 +2050,16 @@ void WD42C22::writeSector(BYTE sectorNo, WORD sectorSizeBytes, WORD* overrideCyl
   // analog to readSector, just without "long mode"  
   // dataPloLength: byte padding of the data field; default 12 bytes + dataPloLength
   const BYTE dataPloLength = 0;
-   
-  BYTE bcr = adRead(0x37);
-  BYTE icr = adRead(0x3B);
-  
-  icr &= 0xF7;
-  adWrite(0x3B, icr);      // make sure MAC = 0 before changing DRWB    
-  bcr |= 4;                // DRWB = 1
-  adWrite(0x37, bcr);
-  adWrite(0x34, 0);        // starting address of data in buffer
-  adWrite(0x35, 0);
-  adWrite(0x3F, 0x40);     // ECCM = 0, DDRQ = 1
-  icr |= 8;
-  adWrite(0x3B, icr);      // MAC = 1  
-  bcr |= 1;
-  adWrite(0x37, bcr);      // ADBP = 1  
-  icr &= 0xF7;
-  adWrite(0x3B, icr);      // MAC = 0
-  
-  WORD currentCyl = m_physicalCylinder;
-  BYTE currentHead = m_physicalHead;
-  if (overrideCyl)
-  {
-    currentCyl = *overrideCyl;
-  }
-  if (overrideHead)
-  {
-    currentHead = *overrideHead;
-  }
-  
-  // prepare task file registers  
-  adWrite(0x21, dataPloLength);           // PLO length
-  adWrite(0x23, sectorNo);                // sector number
-  adWrite(0x24, (BYTE)currentCyl);        // LSB
-  adWrite(0x25, (BYTE)(currentCyl >> 8)); // MSB
-  
-  // prepare SDH register
-  BYTE sdh = getSDHFromSectorSize(sectorSizeBytes);
-
-  // ECC = 1 into SDH  
-  if (m_params.DataVerifyMode != MODE_CRC_16BIT)
-  {
-    sdh |= 0x80;
-  }
-  sdh |= currentHead; // low 3 or 4 bits
-  adWrite(0x26, sdh);
-
-  m_result = WDC_OK;
-  DWORD wait = TIMEOUT_IO;
-  mcintFired = false;
-  adWrite(0x27, 0x30); // write
   
-  while (!mcintFired)
-  {
-    if (!--wait)
-    {
-      m_result = WDC_TIMEOUT;
-      break;
-    }
-  }
-  
-  processResult();
+  Command command = {};
+  command.Opcode = 0x30; // write
+  command.Flags = CMD_WRITE | CMD_PLO;
+  command.PloLength = dataPloLength;
+  command.SectorNo = sectorNo;
+  command.SectorSizeBytes = sectorSizeBytes;
+  command.OverrideCyl = overrideCyl;
+  command.OverrideHead = overrideHead;
+  execute(command);
 }
 
 void WD42C22::setBadSector(BYTE sectorNo, WORD* overrideCyl, BYTE* overrideHead)
@@ -1300,19 +2102,39 @@ void WD42C22::setBadSector(BYTE sectorNo, WORD* overrideCyl, BYTE* overrideHead)
     currentHead = *overrideHead;
   }
   
+  BYTE lowestSectorOnTrack = (BYTE)-1;
+  bool precedingSectorFound = false;
+  BYTE precedingSectorNo = 0;
+  WORD sectorSizeBytes = 0;  
+  
+  // track seen before: the map is known
+  const TrackInfo* cached = getCachedTrack();
+  if (cached)
+  {
+    lowestSectorOnTrack = cached->Geometry.StartSector;
+    for (BYTE index = 0; index < cached->Geometry.SectorsPerTrack; index++)
+    {
+      if (cached->Sectors[index] == sectorNo)
+      {
+        precedingSectorNo = cached->Sectors[(index + cached->Geometry.SectorsPerTrack - 1) % cached->Geometry.SectorsPerTrack];
+        sectorSizeBytes = getSectorSizeFromSDH(cached->SDH);
+        precedingSectorFound = true;
+        break;
+      }
+    }
+    
+    // the sector IDs are about to be rewritten
+    invalidateCachedTrack();
+  }
+  
   WORD tableCount = 0;
-  const DWORD* sectorsTable = wdc->fillSectorsTable(tableCount);
-  if (!sectorsTable || !tableCount)
+  const DWORD* sectorsTable = cached ? NULL : fillSectorsTable(tableCount, (DWORD*)PoolGetScratch()); // callers may hold a pool table
+  if (!cached && (!sectorsTable || !tableCount))
   {
     return;
   }
 
   // analyze the sector map  
-  BYTE lowestSectorOnTrack = (BYTE)-1;
-  bool precedingSectorFound = false;
-  BYTE precedingSectorNo = 0;
-  WORD sectorSizeBytes = 0;  
-  
   for (WORD index = 1; index < tableCount; index++)
   {
     // entry unfilled or invalid
@@ -1345,7 +2167,6 @@ void WD42C22::setBadSector(BYTE sectorNo, WORD* overrideCyl, BYTE* overrideHead)
       }
     }    
   }
-  delete[] sectorsTable;
   
   const bool isFirstSectorOnTrack = (sectorNo == lowestSectorOnTrack);
   if (!isFirstSectorOnTrack && !precedingSectorFound)
@@ -1416,56 +2237,17 @@ void WD42C22::setBadSector(BYTE sectorNo, WORD* overrideCyl, BYTE* overrideHead)
     // load offset to loadParameterBlock() -> use defaults from applyParams(), but set U=1 for writeID to work
     loadParameterBlock(m_params.UseRLL ? 0x33 : 0x4E, 0, true, offset);
     
-    BYTE bcr = adRead(0x37);
-    BYTE icr = adRead(0x3B);
-    
-    icr &= 0xF7;
-    adWrite(0x3B, icr);      // make sure MAC = 0 before changing DRWB    
-    bcr |= 4;                // DRWB = 1
-    adWrite(0x37, bcr);
-    adWrite(0x34, 0xFB);     // starting address of data in buffer - offset 2043
-    adWrite(0x35, 7);
-    adWrite(0x3F, 0x40);     // ECCM = 0, DDRQ = 1
-    icr |= 8;
-    adWrite(0x3B, icr);      // MAC = 1  
-    bcr |= 1;
-    adWrite(0x37, bcr);      // ADBP = 1  
-    icr &= 0xF7;
-    adWrite(0x3B, icr);      // MAC = 0
-    
-    // prepare task file registers  
-    adWrite(0x21, 1);                       // set PLO length to 1 as a zero would cause a 2048-byte PLO field here...
-    adWrite(0x22, 1);                       // sector count
-    adWrite(0x23, sectorNo);                // sector number
-    adWrite(0x24, (BYTE)currentCyl);        // cyl LSB
-    adWrite(0x25, (BYTE)(currentCyl >> 8)); // cyl MSB
-    
-    // prepare SDH register
-    BYTE sdh = getSDHFromSectorSize(sectorSizeBytes);
-
-    // ECC = 1 into SDH  
-    if (m_params.DataVerifyMode != MODE_CRC_16BIT)
-    {
-      sdh |= 0x80;
-    }
-    sdh |= currentHead; // low 3 or 4 bits
-    adWrite(0x26, sdh);
-    
-    m_result = WDC_OK;
-    DWORD wait = TIMEOUT_IO;
-    mcintFired = false;
-    adWrite(0x27, 0xB8); // write ID
-    
-    while (!mcintFired)
-    {
-      if (!--wait)
-      {
-        m_result = WDC_TIMEOUT;
-        break;
-      }
-    }
-    
-    processResult();
+    Command command = {};
+    command.Opcode = 0xB8;         // write ID
+    command.Flags = CMD_WRITE | CMD_COUNT | CMD_PLO;
+    command.PloLength = 1;         // a zero would cause a 2048-byte PLO field here...
+    command.Count = 1;
+    command.SectorNo = sectorNo;
+    command.SectorSizeBytes = sectorSizeBytes;
+    command.BufferOffset = 2043;   // the sector ID prepared above
+    command.OverrideCyl = &currentCyl;
+    command.OverrideHead = &currentHead;
+    execute(command);
     
     // set U back to 0 to disable non-standard sector sizes
     const BYTE saveResult = m_result;
@@ -1491,56 +2273,16 @@ void WD42C22::setBadSector(BYTE sectorNo, WORD* overrideCyl, BYTE* overrideHead)
     sramWriteByteSequential(sectorNo);
     sramFinishBufferAccess();
     
-    BYTE bcr = adRead(0x37);
-    BYTE icr = adRead(0x3B);
-    
-    icr &= 0xF7;
-    adWrite(0x3B, icr);      // make sure MAC = 0 before changing DRWB    
-    bcr |= 4;                // DRWB = 1
-    adWrite(0x37, bcr);
-    adWrite(0x34, 0);        // starting address of interleave table
-    adWrite(0x35, 0);
-    adWrite(0x3F, 0x40);     // ECCM = 0, DDRQ = 1
-    icr |= 8;
-    adWrite(0x3B, icr);      // MAC = 1  
-    bcr |= 1;
-    adWrite(0x37, bcr);      // ADBP = 1  
-    icr &= 0xF7;
-    adWrite(0x3B, icr);      // MAC = 0    
-       
-    // prepare task file registers
-    adWrite(0x21, idPloLength);             // PLO length
-    adWrite(0x22, 1);                       // one sector
-    adWrite(0x23, gapSize-3);               // WD: Gap length written on disk is 3 bytes longer than gap value specified in sector number register
-    adWrite(0x24, (BYTE)currentCyl);        // LSB
-    adWrite(0x25, (BYTE)(currentCyl >> 8)); // MSB
-    
-    // prepare SDH register
-    BYTE sdh = getSDHFromSectorSize(sectorSizeBytes);
-
-    // ECC = 1 into SDH  
-    if (m_params.DataVerifyMode != MODE_CRC_16BIT)
-    {
-      sdh |= 0x80;
-    }
-    sdh |= currentHead; // low 3 or 4 bits
-    adWrite(0x26, sdh);
-    
-    m_result = WDC_OK;
-    DWORD wait = TIMEOUT_IO;
-    mcintFired = false;
-    adWrite(0x27, 0xD3); // format single sector, W=1
-    
-    while (!mcintFired)
-    {
-      if (!--wait)
-      {
-        m_result = WDC_TIMEOUT;
-        break;
-      }
-    }
-    
-    processResult();
+    Command command = {};
+    command.Opcode = 0xD3;         // format single sector, W=1
+    command.Flags = CMD_WRITE | CMD_COUNT | CMD_PLO;
+    command.PloLength = idPloLength;
+    command.Count = 1;
+    command.SectorNo = gapSize-3;
+    command.SectorSizeBytes = sectorSizeBytes;
+    command.OverrideCyl = &currentCyl;
+    command.OverrideHead = &currentHead;
+    execute(command);
   }
   
 }
@@ -20,11 +20,39 @@
 #define WDC_BADBLOCK       7 // bad sector indicator
 #define WDC_CORRECTED      8 // successful ECC correction
 
+// default WDC command deadline, milliseconds
+#define TIMEOUT_IO       3000
+
+// per-track sector ID cache, see TrackInfo
+#define TRACK_CACHE_ENTRIES      4
+#define TRACK_CACHE_MAX_SPT      40
+
+// TrackGeometry.Flags
+#define TRACK_HEAD_MISMATCH      1
+#define TRACK_CYLINDER_MISMATCH  2
+#define TRACK_VARIABLE_SIZE      4
+#define TRACK_ID_GAPS            8 // sector numbers not contiguous, or no full revolution seen: IDs were missed
+
+// ECC corrections of the sectors in the buffer, see Correction
+#define CORRECTION_ENTRIES 16 // 2048 / 128
+
+// Command.Flags
+#define CMD_WRITE          1 // buffer to disk (DRWB = 1): write, format
+#define CMD_COUNT          2 // load the sector count register
+#define CMD_PLO            4 // load the PLO length register
+#define CMD_BUFFER_ONLY    8 // no task file, just the buffer address (compute correction)
+#define CMD_CORRECT       16 // data error in ECC modes: compute correction and apply it before returning
+
 // DiskDriveParams.DataVerifyMode
 #define MODE_CRC_16BIT     0
 #define MODE_ECC_32BIT     1
 #define MODE_ECC_56BIT     2
 
+// DiskDriveParams.SeekProfile, spacing of the step pulses
+#define SEEK_PROFILE_CONSTANT  0 // step rate of the seek mode (SlowSeek or buffered)
+#define SEEK_PROFILE_RAMPED    1 // accelerate from the slow step rate, slow down again before the target
+#define SEEK_PROFILE_BURST     2 // buffered, all pulses as fast as possible
+
 class WD42C22
 {
 public:
@@ -34,7 +62,7 @@ public:
     return &wdc;
   }
   
-  // 20 bytes, needs to be POD
+  // 21 bytes, needs to be POD
   struct DiskDriveParams
   {
     bool UseRLL;
@@ -51,6 +79,74 @@ public:
     bool PartialImage;
     WORD PartialImageStartCyl;
     WORD PartialImageEndCyl;
+    BYTE SeekProfile;
+  };
+  
+  // one revolution of sector IDs, computed while they pass the head; 3 bytes
+  struct TrackGeometry
+  {
+    DWORD SectorsPerTrack : 7;         // 0: no sector ID found
+    DWORD Interleave      : 5;         // 0: could not be determined
+    DWORD StartSector     : 8;         // lowest logical sector number
+    DWORD Flags           : 4;
+  } __attribute__((packed));
+  
+  // what was found on a track with uniform sector IDs, to be reused instead of scanning it again
+  struct TrackInfo
+  {
+    WORD Cylinder;                     // physical
+    BYTE Head;
+    BYTE SDH;                          // same for all sectors
+    WORD LogicalCylinder;              // ditto
+    TrackGeometry Geometry;            // SectorsPerTrack 0: unused entry
+    BYTE Sectors[TRACK_CACHE_MAX_SPT]; // logical sector numbers, in the order as they physically appear
+  };
+  
+  // spindle rotation as timed by measureRotation() on the track under the head; microseconds
+  struct RotationInfo
+  {
+    DWORD Period;                      // one revolution, average
+    DWORD PeriodMin;                   // shortest and longest revolution, the difference is the jitter
+    DWORD PeriodMax;
+    DWORD SectorPeriod;                // Period / SectorsPerTrack
+    DWORD GapPeriod;                   // longest time between two IDs: the track gap (index) is before GapSector
+    DWORD ReferenceMicros;             // when the first ID seen last passed the head, phase 0 in getRotationPhase()
+    BYTE ReferenceSector;              // its logical sector number
+    BYTE GapSector;
+    BYTE SectorsPerTrack;
+    BYTE Revolutions;                  // 0: not measured
+  };
+  
+  // one WDC data command: buffer setup, task file and SDH, see execute()
+  struct Command
+  {
+    BYTE Opcode;
+    BYTE Flags;                        // CMD_ defines
+    BYTE SectorNo;                     // sector number register; gap length for the format commands
+    BYTE Count;                        // sector count register, with CMD_COUNT
+    BYTE PloLength;                    // with CMD_PLO
+    WORD SectorSizeBytes;              // into SDH
+    WORD BufferOffset;
+    WORD* OverrideCyl;                 // logical cylinder and head of the IDs, if they differ from the physical ones
+    BYTE* OverrideHead;
+  };
+  
+  // ECC correction of one sector: XOR pattern and where it goes; with deferred correction, applied on the way out of SRAM
+  struct Correction
+  {
+    WORD Offset;                       // of the first faulty byte, in the SRAM buffer
+    WORD SectorOffset;                 // the same, from the start of the sector data field
+    BYTE Pattern[7];
+    BYTE Length;                       // 4 or 7
+    bool Pending;                      // not in SRAM: applyCorrections() on the data read out
+  };
+  
+  // per opcode group (high nibble), see getCommandStats()
+  struct CommandStats
+  {
+    DWORD Count;
+    DWORD TotalMicros;                 // from issuing the command to /MCINT
+    DWORD MaxMicros;
   };
   
   // functions for buffer SRAM access  
@@ -59,6 +155,17 @@ public:
   void sramWriteByteSequential(BYTE);
   void sramFinishBufferAccess();
   void sramClearBuffer(WORD count = 2048);
+  void sramDiscardBuffer() { m_bufferEnd = 0; } // sector data read so far not needed anymore, a new window of reads follows
+  
+  // burst variants of the above: address latched once, then just /MRE or /MWE strobes
+  void sramReadBlock(BYTE*, WORD);
+  void sramWriteBlock(const BYTE*, WORD);
+  void sramFillBlock(BYTE, WORD);
+  
+  // AD bus reads and writes since resetBusCycles(), and how many the register shadows made unnecessary
+  DWORD getBusCycles() { return m_busCycles; }
+  DWORD getBusCyclesSaved() { return m_busCyclesSaved; }
+  void resetBusCycles() { m_busCycles = 0; m_busCyclesSaved = 0; }
   
   DiskDriveParams* getParams() { return &m_params; }
   
@@ -67,8 +174,14 @@ public:
   bool isDriveReady();
   bool isWriteFault();
   bool isAtCylinder0();
-  bool recalibrate();
+  bool recalibrate(bool fast = true);
+  DWORD getRecalibrateTime() { return m_recalibrateTime; } // ms, last recalibrate()
   bool seekDrive(WORD, BYTE);  
+  bool seekStart(WORD, BYTE);  // non-blocking variant: step pulses out, then poll or wait for the heads to settle
+  bool seekPoll();
+  bool seekWait();
+  DWORD getLastSeekTime() { return m_lastSeekTime; }         // microseconds from the first step pulse to seek complete, 0 if no steps
+  WORD getLastSeekDistance() { return m_lastSeekDistance; }  // cylinders
   bool applyParams();
   void setWindowShift(bool, bool);
   
@@ -78,14 +191,38 @@ public:
   WORD getSectorSizeFromSDH(BYTE);
   BYTE getSDHFromSectorSize(WORD);
   
+  // non-blocking WDC commands: start, then poll until finished or wait for the result
+  void commandStart(BYTE, WORD timeoutMs = TIMEOUT_IO);
+  bool commandPoll();
+  void commandWait();
+  void execute(const Command&, const Command* next = NULL);
+  const CommandStats& getCommandStats(BYTE opcode) { return m_commandStats[opcode >> 4]; }
+  void setDeferredCorrection(bool enable) { m_deferCorrection = enable; m_correctionCount = 0; }
+  void applyCorrections(BYTE* data, WORD bufferOffset, WORD count);
+  BYTE getCorrectionCount() { return m_correctionCount; } // of the sectors in the buffer
+  const Correction& getCorrection(BYTE index) { return m_corrections[index]; }
+  void resetCommandStats() { memset(m_commandStats, 0, sizeof(m_commandStats)); }
+  
   BYTE getLastError() { return m_result; }
   BYTE getLastErrorMessage() { return m_errorMessage; } // Progmem index
   
   void scanID(WORD&, BYTE&, BYTE&);
-  void readSector(BYTE, WORD, bool longMode = false, WORD* overrideCyl = NULL, BYTE* overrideHead = NULL);
+  void readSector(BYTE, WORD, bool longMode = false, WORD* overrideCyl = NULL, BYTE* overrideHead = NULL, WORD bufferOffset = 0);
+  BYTE readSectors(BYTE, BYTE, WORD, WORD* overrideCyl = NULL, BYTE* overrideHead = NULL, BYTE firstIndex = 0);
+  BYTE getSectorStatus(BYTE index) { return (index < sizeof(m_sectorStatus)) ? m_sectorStatus[index] : WDC_NOSECTORID; }
   void verifyTrack(BYTE, WORD, BYTE, WORD* overrideCyl = NULL, BYTE* overrideHead = NULL);
-  DWORD* fillSectorsTable(WORD&);
-  bool prepareFormatInterleave(BYTE, BYTE, BYTE startSector = 1, BYTE* badBlocksTable = NULL);
+  DWORD* fillSectorsTable(WORD&, DWORD* table);
+  const TrackInfo* getCachedTrack();
+  void cacheTrack(const TrackInfo&);
+  void invalidateCachedTrack();
+  void invalidateTrackCache();
+  DWORD getSectorPeriod() { return m_sectorPeriod; } // microseconds, as measured by the last fillSectorsTable
+  const TrackGeometry& getTrackGeometry() { return m_trackGeometry; } // ditto
+  bool measureRotation(BYTE revolutions = ROTATION_REVOLUTIONS);
+  const RotationInfo& getRotation() { return m_rotation; }
+  DWORD getRotationPhase(DWORD atMicros);
+  DWORD getRPM100();
+  bool prepareFormatInterleave(BYTE, BYTE, BYTE startSector = 1, BYTE* badBlocksTable = NULL, BYTE skew = 0);
   void formatTrack(BYTE, WORD, WORD* overrideCyl = NULL, BYTE* overrideHead = NULL);
   void writeSector(BYTE, WORD, WORD* overrideCyl = NULL, BYTE* overrideHead = NULL);
   void setBadSector(BYTE, WORD* overrideCyl = NULL, BYTE* overrideHead = NULL);
@@ -96,19 +233,63 @@ private:
   // inlined functions for "microcontroller interface" access
   inline BYTE adRead(BYTE)                      __attribute__((always_inline));
   inline void adWrite(BYTE, BYTE)               __attribute__((always_inline));
+  inline BYTE regRead(BYTE)                     __attribute__((always_inline));
+  inline void regWrite(BYTE, BYTE)              __attribute__((always_inline));
   
   void resetController();
   void loadParameterBlock(BYTE, BYTE, bool useNonStandardSizes = false, WORD nonStandardSize = 0);
   void setParameter();
   void processResult();
+  void recalibrateBurst();
+  void deadlineArm(WORD);
+  void deadlineStart(WORD);
+  void prepareBuffer(bool, WORD);
+  void stageCommand(const Command&);
+  void dropStagedCommand() { m_staged.Source = NULL; }
   void computeCorrection();
-  void doCorrection();
+  void doCorrection(WORD bufferOffset = 0, const BYTE* keepTail = NULL);
+  void dropCorrections(WORD from, WORD to);
   
   bool m_seekForward;
+  bool m_seekPending;
   WORD m_physicalCylinder;
   BYTE m_physicalHead;
   BYTE m_result;
   BYTE m_errorMessage;
+  BYTE m_sectorStatus[16]; // readSectors, 2048 / 128
+  DWORD m_sectorPeriod;
+  DWORD m_recalibrateTime;
+  DWORD m_seekStartMicros;
+  DWORD m_lastSeekTime;
+  WORD m_lastSeekDistance;
+  TrackGeometry m_trackGeometry;
+  RotationInfo m_rotation;
+  TrackInfo m_trackCache[TRACK_CACHE_ENTRIES];
+  BYTE m_trackCacheNext;
+  BYTE m_bcr;              // register shadows, see regWrite()
+  BYTE m_icr;
+  BYTE m_reg3F;
+  BYTE m_taskFile[6];      // 0x21-0x26
+  BYTE m_taskFileValid;    // bit 0: 0x21 ... bit 5: 0x26
+  DWORD m_busCycles;
+  DWORD m_busCyclesSaved;
+  
+  // task file of the command to be issued next, computed ahead while the previous one runs
+  struct StagedCommand
+  {
+    const Command* Source;
+    BYTE TaskFile[6];        // 0x21-0x26
+    BYTE Mask;               // which of them to load
+  };
+  StagedCommand m_staged;
+  CommandStats m_commandStats[16];
+  Correction m_corrections[CORRECTION_ENTRIES];
+  BYTE m_correctionCount;
+  bool m_deferCorrection;
+  WORD m_bufferEnd;        // end of the sector data read into SRAM since sramDiscardBuffer(), to be kept by corrections
+  BYTE m_commandOpcode;
+  bool m_commandTimed;
+  DWORD m_commandStartMicros;
   
   DiskDriveParams m_params = {};
 };
\ No newline at end of file